@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/search_rpc.dir/rpc/rpc_server.cpp.o"
+  "CMakeFiles/search_rpc.dir/rpc/rpc_server.cpp.o.d"
+  "libsearch_rpc.a"
+  "libsearch_rpc.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/search_rpc.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
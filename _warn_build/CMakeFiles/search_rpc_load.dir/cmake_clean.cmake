@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/search_rpc_load.dir/rpc/search_rpc_load.cpp.o"
+  "CMakeFiles/search_rpc_load.dir/rpc/search_rpc_load.cpp.o.d"
+  "search_rpc_load"
+  "search_rpc_load.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/search_rpc_load.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
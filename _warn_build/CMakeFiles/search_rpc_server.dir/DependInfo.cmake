@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/rpc/search_rpc_server.cpp" "CMakeFiles/search_rpc_server.dir/rpc/search_rpc_server.cpp.o" "gcc" "CMakeFiles/search_rpc_server.dir/rpc/search_rpc_server.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_warn_build/CMakeFiles/search_rpc.dir/DependInfo.cmake"
+  "/root/repo/_warn_build/CMakeFiles/search_server_core.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/search_rpc_server.dir/rpc/search_rpc_server.cpp.o"
+  "CMakeFiles/search_rpc_server.dir/rpc/search_rpc_server.cpp.o.d"
+  "search_rpc_server"
+  "search_rpc_server.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/search_rpc_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,40 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/search-server/analyzer.cpp" "CMakeFiles/search_server_core.dir/search-server/analyzer.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/analyzer.cpp.o.d"
+  "/root/repo/search-server/corpus_statistics.cpp" "CMakeFiles/search_server_core.dir/search-server/corpus_statistics.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/corpus_statistics.cpp.o.d"
+  "/root/repo/search-server/document.cpp" "CMakeFiles/search_server_core.dir/search-server/document.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/document.cpp.o.d"
+  "/root/repo/search-server/generators.cpp" "CMakeFiles/search_server_core.dir/search-server/generators.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/generators.cpp.o.d"
+  "/root/repo/search-server/index_statistics.cpp" "CMakeFiles/search_server_core.dir/search-server/index_statistics.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/index_statistics.cpp.o.d"
+  "/root/repo/search-server/ingest.cpp" "CMakeFiles/search_server_core.dir/search-server/ingest.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/ingest.cpp.o.d"
+  "/root/repo/search-server/memory_resources.cpp" "CMakeFiles/search_server_core.dir/search-server/memory_resources.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/memory_resources.cpp.o.d"
+  "/root/repo/search-server/metrics.cpp" "CMakeFiles/search_server_core.dir/search-server/metrics.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/metrics.cpp.o.d"
+  "/root/repo/search-server/process_queries.cpp" "CMakeFiles/search_server_core.dir/search-server/process_queries.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/process_queries.cpp.o.d"
+  "/root/repo/search-server/query_profile.cpp" "CMakeFiles/search_server_core.dir/search-server/query_profile.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/query_profile.cpp.o.d"
+  "/root/repo/search-server/read_input_functions.cpp" "CMakeFiles/search_server_core.dir/search-server/read_input_functions.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/read_input_functions.cpp.o.d"
+  "/root/repo/search-server/remove_duplicates.cpp" "CMakeFiles/search_server_core.dir/search-server/remove_duplicates.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/remove_duplicates.cpp.o.d"
+  "/root/repo/search-server/request_queue.cpp" "CMakeFiles/search_server_core.dir/search-server/request_queue.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/request_queue.cpp.o.d"
+  "/root/repo/search-server/request_stats.cpp" "CMakeFiles/search_server_core.dir/search-server/request_stats.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/request_stats.cpp.o.d"
+  "/root/repo/search-server/rpc_protocol.cpp" "CMakeFiles/search_server_core.dir/search-server/rpc_protocol.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/rpc_protocol.cpp.o.d"
+  "/root/repo/search-server/scoring.cpp" "CMakeFiles/search_server_core.dir/search-server/scoring.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/scoring.cpp.o.d"
+  "/root/repo/search-server/search_server.cpp" "CMakeFiles/search_server_core.dir/search-server/search_server.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/search_server.cpp.o.d"
+  "/root/repo/search-server/sharded_search_server.cpp" "CMakeFiles/search_server_core.dir/search-server/sharded_search_server.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/sharded_search_server.cpp.o.d"
+  "/root/repo/search-server/snapshot.cpp" "CMakeFiles/search_server_core.dir/search-server/snapshot.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/snapshot.cpp.o.d"
+  "/root/repo/search-server/stop_words.cpp" "CMakeFiles/search_server_core.dir/search-server/stop_words.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/stop_words.cpp.o.d"
+  "/root/repo/search-server/string_processing.cpp" "CMakeFiles/search_server_core.dir/search-server/string_processing.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/string_processing.cpp.o.d"
+  "/root/repo/search-server/test_example_functions.cpp" "CMakeFiles/search_server_core.dir/search-server/test_example_functions.cpp.o" "gcc" "CMakeFiles/search_server_core.dir/search-server/test_example_functions.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,53 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/search_server_core.dir/search-server/analyzer.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/analyzer.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/corpus_statistics.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/corpus_statistics.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/document.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/document.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/generators.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/generators.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/index_statistics.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/index_statistics.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/ingest.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/ingest.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/memory_resources.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/memory_resources.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/metrics.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/metrics.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/process_queries.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/process_queries.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/query_profile.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/query_profile.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/read_input_functions.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/read_input_functions.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/remove_duplicates.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/remove_duplicates.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/request_queue.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/request_queue.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/request_stats.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/request_stats.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/rpc_protocol.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/rpc_protocol.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/scoring.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/scoring.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/search_server.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/search_server.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/sharded_search_server.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/sharded_search_server.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/snapshot.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/snapshot.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/stop_words.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/stop_words.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/string_processing.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/string_processing.cpp.o.d"
+  "CMakeFiles/search_server_core.dir/search-server/test_example_functions.cpp.o"
+  "CMakeFiles/search_server_core.dir/search-server/test_example_functions.cpp.o.d"
+  "libsearch_server_core.a"
+  "libsearch_server_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/search_server_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
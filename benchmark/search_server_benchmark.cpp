@@ -0,0 +1,410 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "generators.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace
+{
+const int QUERY_COUNT = 200;
+
+// Журнал запросов для BM_ReplayQueryLog, задаётся флагом --query_log=<путь>
+vector<string> replay_queries;
+
+// Аргументы всех бенчмарков: число документов, перекос Ципфа * 100, слов в запросе, вероятность минус-слова в процентах
+struct WorkloadParams
+{
+    int document_count;
+    double zipf_skew;
+    int query_word_count;
+    double minus_prob;
+
+    explicit WorkloadParams(const benchmark::State &state)
+        : document_count(static_cast<int>(state.range(0))),
+          zipf_skew(state.range(1) / 100.0),
+          query_word_count(static_cast<int>(state.range(2))),
+          minus_prob(state.range(3) / 100.0)
+    {
+    }
+
+    auto AsTuple() const
+    {
+        return tie(document_count, zipf_skew, query_word_count, minus_prob);
+    }
+
+    bool operator<(const WorkloadParams &other) const
+    {
+        return AsTuple() < other.AsTuple();
+    }
+
+    WorkloadConfig ToConfig() const
+    {
+        WorkloadConfig config;
+        config.dictionary_size = 2'000;
+        config.document_count = document_count;
+        config.zipf_skew = zipf_skew;
+        config.query_count = QUERY_COUNT;
+        config.max_query_word_count = query_word_count;
+        config.minus_prob = minus_prob;
+        return config;
+    }
+};
+
+struct IndexedWorkload
+{
+    Workload data;
+    unique_ptr<SearchServer> server;
+};
+
+// Корпус строится один раз на набор параметров; сид фиксирован, чтобы результаты были воспроизводимы
+const IndexedWorkload &GetWorkload(const WorkloadParams &params)
+{
+    static map<WorkloadParams, IndexedWorkload> cache;
+    auto it = cache.find(params);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+
+    IndexedWorkload result;
+    result.data = GenerateWorkload(params.ToConfig());
+    result.server = make_unique<SearchServer>(result.data.GetStopWordsText());
+    for (int id = 0; id < params.document_count; ++id)
+    {
+        result.server->AddDocument(id, result.data.documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    return cache.emplace(params, move(result)).first->second;
+}
+
+void BM_AddDocument(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    std::optional<SearchServer> server;
+    for (auto _ : state)
+    {
+        server.emplace(workload.data.GetStopWordsText());
+        for (size_t id = 0; id < workload.data.documents.size(); ++id)
+        {
+            server->AddDocument(static_cast<int>(id), workload.data.documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        benchmark::DoNotOptimize(server->GetDocumentCount());
+    }
+    // занятое узлами и взятое пулами у системы, в байтах; снимается после замеров
+    if (server)
+    {
+        const IndexMemoryStats memory = server->GetMemoryStats();
+        state.counters["live_bytes"] = memory.postings.live_bytes + memory.forward_index.live_bytes;
+        state.counters["reserved_bytes"] = memory.postings.reserved_bytes + memory.forward_index.reserved_bytes;
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.documents.size());
+}
+
+// те же документы через анализатор со всеми включёнными опциями; текст генератора - ASCII
+void BM_AddDocumentAnalyzed(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    AnalyzerOptions options;
+    options.fold_case = true;
+    options.split_punctuation = true;
+    options.stem = true;
+    for (auto _ : state)
+    {
+        SearchServer server(workload.data.GetStopWordsText());
+        server.SetAnalyzerOptions(options);
+        for (size_t id = 0; id < workload.data.documents.size(); ++id)
+        {
+            server.AddDocument(static_cast<int>(id), workload.data.documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        benchmark::DoNotOptimize(server.GetDocumentCount());
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.documents.size());
+}
+
+void BM_RemoveDocument(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    // сервер прошлой итерации разрушается при паузе, вне замера
+    std::optional<SearchServer> server;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        server.emplace(workload.data.GetStopWordsText());
+        for (size_t id = 0; id < workload.data.documents.size(); ++id)
+        {
+            server->AddDocument(static_cast<int>(id), workload.data.documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        state.ResumeTiming();
+        for (size_t id = 0; id < workload.data.documents.size(); ++id)
+        {
+            server->RemoveDocument(static_cast<int>(id));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.documents.size());
+}
+
+void BM_RemoveDocuments(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    std::vector<int> document_ids(workload.data.documents.size());
+    std::iota(document_ids.begin(), document_ids.end(), 0);
+    // сервер прошлой итерации разрушается при паузе, вне замера
+    std::optional<SearchServer> server;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        server.emplace(workload.data.GetStopWordsText());
+        for (size_t id = 0; id < workload.data.documents.size(); ++id)
+        {
+            server->AddDocument(static_cast<int>(id), workload.data.documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        state.ResumeTiming();
+        server->RemoveDocuments(document_ids);
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.documents.size());
+}
+
+template <typename ExecutionPolicy>
+void BM_FindTopDocuments(benchmark::State &state, ExecutionPolicy policy)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    for (auto _ : state)
+    {
+        for (const string &query : workload.data.queries)
+        {
+            benchmark::DoNotOptimize(workload.server->FindTopDocuments(policy, query));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.queries.size());
+}
+
+// запросы с бюджетом постингов: хвост латентности против доли точных результатов
+void BM_FindTopDocumentsWithin(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    QueryBudget budget;
+    budget.max_postings = 1000;
+    size_t partial_count = 0;
+    for (auto _ : state)
+    {
+        for (const string &query : workload.data.queries)
+        {
+            const SearchResult result = workload.server->FindTopDocumentsWithin(budget, query);
+            partial_count += result.is_partial;
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.queries.size());
+    state.counters["partial_pct"] = 100.0 * partial_count / (state.iterations() * workload.data.queries.size());
+}
+
+void BM_FindTopDocumentsRanking(benchmark::State &state, RankingModel model)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    SearchServer &server = *workload.server;
+    RankingOptions options;
+    options.model = model;
+    server.SetRankingOptions(options);
+    for (auto _ : state)
+    {
+        for (const string &query : workload.data.queries)
+        {
+            benchmark::DoNotOptimize(server.FindTopDocuments(query));
+        }
+    }
+    server.SetRankingOptions({});
+    state.SetItemsProcessed(state.iterations() * workload.data.queries.size());
+}
+
+// тот же корпус с упорядоченными по вкладу постингами; копия сервера, чтобы не трогать общий кэш
+void BM_FindTopDocumentsImpact(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    SearchServer server(workload.data.GetStopWordsText());
+    for (size_t id = 0; id < workload.data.documents.size(); ++id)
+    {
+        server.AddDocument(static_cast<int>(id), workload.data.documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    server.BuildImpactIndex();
+    for (auto _ : state)
+    {
+        for (const string &query : workload.data.queries)
+        {
+            benchmark::DoNotOptimize(server.FindTopDocuments(query));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.queries.size());
+}
+
+// в каждом слове запроса пропущена одна буква; отрицательные слова не трогаются
+void BM_FindTopDocumentsFuzzy(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    mt19937 generator(7);
+    vector<string> queries;
+    for (const string &query : workload.data.queries)
+    {
+        string typo_query;
+        for (const string_view word : SearchServer::SplitIntoWords(query))
+        {
+            string typo_word(word);
+            if (typo_word[0] != '-' && typo_word.size() > 1)
+            {
+                typo_word.erase(uniform_int_distribution<size_t>(0, typo_word.size() - 1)(generator), 1);
+            }
+            typo_query += typo_word + ' ';
+        }
+        queries.push_back(move(typo_query));
+    }
+
+    SearchServer &server = *workload.server;
+    TermExpansionOptions options;
+    options.max_edit_distance = static_cast<int>(state.range(4));
+    server.SetTermExpansionOptions(options);
+    for (auto _ : state)
+    {
+        for (const string &query : queries)
+        {
+            benchmark::DoNotOptimize(server.FindTopDocuments(query));
+        }
+    }
+    server.SetTermExpansionOptions({});
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+template <typename ExecutionPolicy>
+void BM_MatchDocument(benchmark::State &state, ExecutionPolicy policy)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    const int document_count = workload.server->GetDocumentCount();
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < workload.data.queries.size(); ++i)
+        {
+            benchmark::DoNotOptimize(workload.server->MatchDocument(policy, workload.data.queries[i], static_cast<int>(i) % document_count));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.queries.size());
+}
+
+void BM_ProcessQueries(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ProcessQueries(*workload.server, workload.data.queries));
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.queries.size());
+}
+
+void BM_RemoveDuplicates(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    // FindDuplicates сервер не меняет: он строится один раз и разрушается после замеров
+    SearchServer server(workload.data.GetStopWordsText());
+    // каждый четвёртый документ - копия предыдущего
+    for (size_t id = 0; id < workload.data.documents.size(); ++id)
+    {
+        const size_t source = id % 4 == 3 ? id - 1 : id;
+        server.AddDocument(static_cast<int>(id), workload.data.documents[source], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(FindDuplicates(server));
+    }
+    state.SetItemsProcessed(state.iterations() * workload.data.documents.size());
+}
+
+void BM_ReplayQueryLog(benchmark::State &state)
+{
+    const IndexedWorkload &workload = GetWorkload(WorkloadParams(state));
+    for (auto _ : state)
+    {
+        for (const string &query : replay_queries)
+        {
+            benchmark::DoNotOptimize(workload.server->FindTopDocuments(query));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * replay_queries.size());
+}
+
+void WorkloadArgs(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgNames({"docs", "zipf_x100", "query_words", "minus_pct"});
+    benchmark->ArgsProduct({{1'000, 10'000}, {0, 100}, {3, 10}, {0, 20}});
+    benchmark->Unit(benchmark::kMicrosecond);
+}
+
+void FuzzyArgs(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgNames({"docs", "zipf_x100", "query_words", "minus_pct", "edit_distance"});
+    benchmark->ArgsProduct({{10'000}, {100}, {3}, {0}, {1, 2}});
+    benchmark->Unit(benchmark::kMicrosecond);
+}
+
+void CorpusArgs(benchmark::internal::Benchmark *benchmark)
+{
+    benchmark->ArgNames({"docs", "zipf_x100", "query_words", "minus_pct"});
+    benchmark->ArgsProduct({{1'000, 10'000}, {0, 100}, {3}, {0}});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+}
+
+BENCHMARK(BM_AddDocument)->Apply(CorpusArgs);
+BENCHMARK(BM_AddDocumentAnalyzed)->Apply(CorpusArgs);
+BENCHMARK(BM_RemoveDocument)->Apply(CorpusArgs);
+BENCHMARK(BM_RemoveDocuments)->Apply(CorpusArgs);
+BENCHMARK_CAPTURE(BM_FindTopDocuments, seq, std::execution::seq)->Apply(WorkloadArgs);
+BENCHMARK_CAPTURE(BM_FindTopDocuments, par, std::execution::par)->Apply(WorkloadArgs);
+BENCHMARK_CAPTURE(BM_FindTopDocumentsRanking, tf_idf, RankingModel::TF_IDF)->Apply(WorkloadArgs);
+BENCHMARK_CAPTURE(BM_FindTopDocumentsRanking, bm25, RankingModel::BM25)->Apply(WorkloadArgs);
+BENCHMARK(BM_FindTopDocumentsWithin)->Apply(WorkloadArgs);
+BENCHMARK(BM_FindTopDocumentsImpact)->Apply(WorkloadArgs);
+BENCHMARK(BM_FindTopDocumentsFuzzy)->Apply(FuzzyArgs);
+BENCHMARK_CAPTURE(BM_MatchDocument, seq, std::execution::seq)->Apply(WorkloadArgs);
+BENCHMARK_CAPTURE(BM_MatchDocument, par, std::execution::par)->Apply(WorkloadArgs);
+BENCHMARK(BM_ProcessQueries)->Apply(WorkloadArgs);
+BENCHMARK(BM_RemoveDuplicates)->Apply(CorpusArgs);
+
+int main(int argc, char **argv)
+{
+    const string query_log_flag = "--query_log="s;
+    vector<char *> benchmark_args;
+    for (int i = 0; i < argc; ++i)
+    {
+        const string_view arg = argv[i];
+        if (arg.substr(0, query_log_flag.size()) == query_log_flag)
+        {
+            replay_queries = ReadQueryLog(string(arg.substr(query_log_flag.size())));
+        }
+        else
+        {
+            benchmark_args.push_back(argv[i]);
+        }
+    }
+    if (!replay_queries.empty())
+    {
+        benchmark::RegisterBenchmark("BM_ReplayQueryLog", BM_ReplayQueryLog)->Apply(CorpusArgs);
+    }
+
+    int benchmark_argc = static_cast<int>(benchmark_args.size());
+    benchmark::Initialize(&benchmark_argc, benchmark_args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchmark_argc, benchmark_args.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,349 @@
+#include "rpc_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "rpc_protocol.h"
+
+namespace
+{
+const int MAX_EVENTS = 128;
+const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+[[noreturn]] void ThrowSystemError(const std::string &what)
+{
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+void SetNonBlocking(int fd)
+{
+    if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0)
+    {
+        ThrowSystemError("fcntl");
+    }
+}
+
+void AddToEpoll(int epoll_fd, int fd, uint32_t events)
+{
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        ThrowSystemError("epoll_ctl");
+    }
+}
+}
+
+RpcServer::RpcServer(SearchServer &server, const RpcServerOptions &options)
+    : server_(server), unix_socket_path_(options.unix_socket_path), limits_(options.limits)
+{
+    if (!unix_socket_path_.empty())
+    {
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (unix_socket_path_.size() >= sizeof(address.sun_path))
+        {
+            throw std::invalid_argument("Unix socket path is too long");
+        }
+        std::strcpy(address.sun_path, unix_socket_path_.c_str());
+        unlink(unix_socket_path_.c_str());
+        if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            ThrowSystemError("bind " + unix_socket_path_);
+        }
+    }
+    else
+    {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        const int enable = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.tcp_port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            ThrowSystemError("bind port " + std::to_string(options.tcp_port));
+        }
+    }
+    if (listen(listen_fd_, SOMAXCONN) < 0)
+    {
+        ThrowSystemError("listen");
+    }
+    SetNonBlocking(listen_fd_);
+
+    epoll_fd_ = epoll_create1(0);
+    stop_fd_ = eventfd(0, EFD_NONBLOCK);
+    if (epoll_fd_ < 0 || stop_fd_ < 0)
+    {
+        ThrowSystemError("epoll_create1/eventfd");
+    }
+    AddToEpoll(epoll_fd_, listen_fd_, EPOLLIN);
+    AddToEpoll(epoll_fd_, stop_fd_, EPOLLIN);
+}
+
+RpcServer::~RpcServer()
+{
+    for (const auto &[fd, _] : connections_)
+    {
+        close(fd);
+    }
+    close(stop_fd_);
+    close(epoll_fd_);
+    close(listen_fd_);
+    if (!unix_socket_path_.empty())
+    {
+        unlink(unix_socket_path_.c_str());
+    }
+}
+
+void RpcServer::Stop()
+{
+    const uint64_t one = 1;
+    // write безопасен в обработчике сигнала
+    [[maybe_unused]] const ssize_t written = write(stop_fd_, &one, sizeof(one));
+}
+
+void RpcServer::Run()
+{
+    epoll_event events[MAX_EVENTS];
+    std::vector<std::pair<int, std::string_view>> batch;
+    std::vector<std::string_view> frames;
+    while (true)
+    {
+        const int event_count = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (event_count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            ThrowSystemError("epoll_wait");
+        }
+
+        for (int i = 0; i < event_count; ++i)
+        {
+            const int fd = events[i].data.fd;
+            if (fd == stop_fd_)
+            {
+                return;
+            }
+            if (fd == listen_fd_)
+            {
+                Accept();
+                continue;
+            }
+            Connection &connection = connections_.at(fd);
+            if (events[i].events & (EPOLLHUP | EPOLLERR))
+            {
+                connection.closed = true;
+            }
+            if ((events[i].events & EPOLLIN) && !connection.paused)
+            {
+                Read(fd, connection);
+            }
+            if (events[i].events & EPOLLOUT)
+            {
+                Flush(fd, connection);
+            }
+        }
+
+        // все кадры, пришедшие к этому моменту по всем соединениям, - одна пачка. Соединение,
+        // которое пачка сняла с паузы, отдаёт оставшиеся кадры в следующую
+        while (true)
+        {
+            batch.clear();
+            for (auto &[fd, connection] : connections_)
+            {
+                if (connection.paused || connection.closed)
+                {
+                    continue;
+                }
+                std::string_view input = connection.input;
+                try
+                {
+                    size_t frame_size;
+                    while ((frame_size = GetCompleteFrameSize(input)) > 0)
+                    {
+                        batch.emplace_back(fd, input.substr(0, frame_size));
+                        input.remove_prefix(frame_size);
+                    }
+                }
+                catch (const std::invalid_argument &)
+                {
+                    connection.closed = true;
+                }
+            }
+            if (batch.empty())
+            {
+                break;
+            }
+            frames.clear();
+            for (const auto &[fd, frame] : batch)
+            {
+                frames.push_back(frame);
+            }
+            const std::vector<std::string> responses = HandleRpcBatch(server_, frames, limits_);
+            std::unordered_map<int, size_t> consumed;
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                Connection &connection = connections_.at(batch[i].first);
+                connection.output += responses[i];
+                consumed[batch[i].first] += batch[i].second.size();
+            }
+            for (const auto &[fd, size] : consumed)
+            {
+                Connection &connection = connections_.at(fd);
+                connection.input.erase(0, size);
+                Flush(fd, connection);
+            }
+        }
+
+        std::vector<int> closed;
+        for (const auto &[fd, connection] : connections_)
+        {
+            // полученные до конца потока кадры уже в пачке выше, остаётся дождаться отправки ответов
+            if (connection.closed || (connection.read_closed && connection.output.empty()))
+            {
+                closed.push_back(fd);
+            }
+        }
+        for (const int fd : closed)
+        {
+            CloseConnection(fd);
+        }
+    }
+}
+
+void RpcServer::Accept()
+{
+    while (true)
+    {
+        const int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            {
+                return;
+            }
+            ThrowSystemError("accept");
+        }
+        SetNonBlocking(fd);
+        if (unix_socket_path_.empty())
+        {
+            const int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+        AddToEpoll(epoll_fd_, fd, EPOLLIN);
+        connections_.emplace(fd, Connection{});
+    }
+}
+
+void RpcServer::Read(int fd, Connection &connection)
+{
+    char buffer[READ_CHUNK_SIZE];
+    while (true)
+    {
+        const ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size > 0)
+        {
+            connection.input.append(buffer, static_cast<size_t>(size));
+            // остаток дочитается на следующем витке: EPOLLIN срабатывает, пока в сокете есть данные
+            if (connection.input.size() >= limits_.max_pending_output_bytes)
+            {
+                return;
+            }
+            continue;
+        }
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return;
+        }
+        if (size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (size == 0)
+        {
+            // конец потока не снимается чтением: без EPOLLIN epoll не будет будить цикл впустую
+            connection.read_closed = true;
+            UpdateEvents(fd, connection);
+        }
+        else
+        {
+            connection.closed = true;
+        }
+        return;
+    }
+}
+
+// Отправляет сколько примет сокет; пока буфер не пуст, соединение ждёт EPOLLOUT
+void RpcServer::Flush(int fd, Connection &connection)
+{
+    while (connection.output_offset < connection.output.size())
+    {
+        const ssize_t size = send(fd, connection.output.data() + connection.output_offset,
+                                  connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (size < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                connection.closed = true;
+                return;
+            }
+            break;
+        }
+        connection.output_offset += static_cast<size_t>(size);
+    }
+
+    // отправленное начало буфера убирается, иначе у медленно читающего клиента буфер рос бы без конца
+    if (connection.output_offset * 2 >= connection.output.size())
+    {
+        connection.output.erase(0, connection.output_offset);
+        connection.output_offset = 0;
+    }
+    const size_t pending = connection.output.size() - connection.output_offset;
+    if (pending > limits_.max_pending_output_bytes)
+    {
+        connection.paused = true;
+    }
+    else if (pending <= limits_.resume_output_bytes)
+    {
+        connection.paused = false;
+    }
+    UpdateEvents(fd, connection);
+}
+
+void RpcServer::UpdateEvents(int fd, const Connection &connection)
+{
+    epoll_event event{};
+    const bool reading = !connection.read_closed && !connection.paused;
+    event.events = (reading ? uint32_t{EPOLLIN} : 0u) | (connection.output.empty() ? 0u : uint32_t{EPOLLOUT});
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+}
+
+void RpcServer::CloseConnection(int fd)
+{
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+}
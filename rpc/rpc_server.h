@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "rpc_protocol.h"
+#include "search_server.h"
+
+struct RpcServerOptions
+{
+    // непустой путь - Unix-сокет, иначе TCP на 127.0.0.1:tcp_port
+    std::string unix_socket_path;
+    int tcp_port = 0;
+    RpcLimits limits;
+};
+
+// Однопоточный цикл epoll: читает все готовые соединения, собирает полученные целиком кадры
+// в одну пачку и выполняет её через HandleRpcBatch, ответы дописывает в буферы соединений
+class RpcServer
+{
+public:
+    RpcServer(SearchServer &server, const RpcServerOptions &options);
+    ~RpcServer();
+
+    RpcServer(const RpcServer &) = delete;
+    RpcServer &operator=(const RpcServer &) = delete;
+
+    // до вызова Stop
+    void Run();
+    // можно вызывать из другого потока и из обработчика сигнала
+    void Stop();
+
+private:
+    struct Connection
+    {
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+        // ошибка сокета или протокола: соединение закрывается сразу
+        bool closed = false;
+        // клиент закрыл свою сторону (shutdown(SHUT_WR)): соединение закрывается, когда уйдут ответы
+        bool read_closed = false;
+        // клиент не забирает ответы: новые запросы не читаются, пока буфер ответов не опустеет
+        bool paused = false;
+    };
+
+    void Accept();
+    void Read(int fd, Connection &connection);
+    void Flush(int fd, Connection &connection);
+    void UpdateEvents(int fd, const Connection &connection);
+    void CloseConnection(int fd);
+
+    SearchServer &server_;
+    std::string unix_socket_path_;
+    RpcLimits limits_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1;
+    std::unordered_map<int, Connection> connections_;
+};
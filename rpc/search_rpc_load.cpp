@@ -0,0 +1,297 @@
+// Нагрузочный клиент для search_rpc_server.
+//   search_rpc_load --write_snapshot=corpus.tsv [--docs=10000]    - корпус и стоп-слова из GenerateWorkload
+//   search_rpc_load (--port=7000 | --unix=/tmp/search.sock) [--connections=4] [--pipeline=16]
+//                   [--requests=100000] [--query_log=queries.txt]
+// Каждое соединение держит pipeline запросов в полёте; в конце печатаются пропускная способность
+// и квантили задержки от отправки запроса до получения ответа
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "generators.h"
+#include "metrics.h"
+#include "rpc_protocol.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+namespace
+{
+struct LoadOptions
+{
+    string unix_socket_path;
+    int tcp_port = 0;
+    int connections = 4;
+    int pipeline = 16;
+    int requests = 100'000;
+};
+
+struct ConnectionResult
+{
+    LatencyHistogram latency;
+    uint64_t errors = 0;
+};
+
+int Connect(const LoadOptions &options)
+{
+    int fd;
+    if (!options.unix_socket_path.empty())
+    {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, options.unix_socket_path.c_str(), sizeof(address.sun_path) - 1);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            throw runtime_error("connect "s + options.unix_socket_path + ": "s + strerror(errno));
+        }
+    }
+    else
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(options.tcp_port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            throw runtime_error("connect: "s + strerror(errno));
+        }
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+    return fd;
+}
+
+void SendAll(int fd, string_view data)
+{
+    while (!data.empty())
+    {
+        const ssize_t size = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (size <= 0)
+        {
+            throw runtime_error("send: "s + strerror(errno));
+        }
+        data.remove_prefix(static_cast<size_t>(size));
+    }
+}
+
+// дочитывает из сокета, пока в buffer не окажется целый кадр, и снимает его
+string ReceiveFrame(int fd, string &buffer)
+{
+    char chunk[64 * 1024];
+    size_t frame_size;
+    while ((frame_size = GetCompleteFrameSize(buffer)) == 0)
+    {
+        const ssize_t size = recv(fd, chunk, sizeof(chunk), 0);
+        if (size <= 0)
+        {
+            throw runtime_error("connection closed by server"s);
+        }
+        buffer.append(chunk, static_cast<size_t>(size));
+    }
+    string frame = buffer.substr(0, frame_size);
+    buffer.erase(0, frame_size);
+    return frame;
+}
+
+ConnectionResult RunConnection(const LoadOptions &options, const vector<string> &queries, atomic_int &next_request)
+{
+    ConnectionResult result;
+    const int fd = Connect(options);
+    string buffer;
+    // время отправки по id запроса; id растут, ответы приходят по порядку
+    vector<Clock::time_point> sent;
+    size_t in_flight = 0;
+    size_t received = 0;
+
+    const auto send_next = [&]()
+    {
+        const int request = next_request.fetch_add(1, memory_order_relaxed);
+        if (request >= options.requests)
+        {
+            return false;
+        }
+        const string frame = RpcWriter(static_cast<uint8_t>(RpcType::FIND_TOP_DOCUMENTS), static_cast<uint32_t>(sent.size()))
+                                     .WriteString(queries[static_cast<size_t>(request) % queries.size()])
+                                     .WriteUint8(static_cast<uint8_t>(DocumentStatus::ACTUAL))
+                                     .Finish();
+        sent.push_back(Clock::now());
+        SendAll(fd, frame);
+        ++in_flight;
+        return true;
+    };
+
+    for (int i = 0; i < options.pipeline && send_next(); ++i)
+    {
+    }
+    while (in_flight > 0)
+    {
+        RpcReader reader(ReceiveFrame(fd, buffer));
+        const uint64_t latency_ns = static_cast<uint64_t>(
+                chrono::duration_cast<chrono::nanoseconds>(Clock::now() - sent.at(reader.GetRequestId())).count());
+        ++result.latency.buckets[LatencyHistogram::GetBucket(latency_ns)];
+        ++result.latency.count;
+        result.latency.sum_ns += latency_ns;
+        if (reader.GetType() != (static_cast<uint8_t>(RpcType::FIND_TOP_DOCUMENTS) | RPC_RESPONSE_FLAG))
+        {
+            ++result.errors;
+        }
+        --in_flight;
+        ++received;
+        send_next();
+    }
+    close(fd);
+    return result;
+}
+
+void WriteSnapshot(const string &path, int document_count)
+{
+    WorkloadConfig config;
+    config.document_count = document_count;
+    const Workload workload = GenerateWorkload(config);
+    ofstream output(path);
+    for (size_t id = 0; id < workload.documents.size(); ++id)
+    {
+        output << id << '\t' << static_cast<int>(DocumentStatus::ACTUAL) << '\t' << id % 10 << '\t'
+               << workload.documents[id] << '\n';
+    }
+    cout << "--stop_words=\""s << workload.GetStopWordsText() << '"' << endl;
+}
+
+bool ParseFlag(string_view arg, string_view name, string &value)
+{
+    if (arg.substr(0, name.size()) != name)
+    {
+        return false;
+    }
+    value = string(arg.substr(name.size()));
+    return true;
+}
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+    string port, connections, pipeline, requests, query_log, snapshot_path, documents = "10000"s;
+    for (int i = 1; i < argc; ++i)
+    {
+        const string_view arg = argv[i];
+        if (!ParseFlag(arg, "--port="sv, port) && !ParseFlag(arg, "--unix="sv, options.unix_socket_path)
+            && !ParseFlag(arg, "--connections="sv, connections) && !ParseFlag(arg, "--pipeline="sv, pipeline)
+            && !ParseFlag(arg, "--requests="sv, requests) && !ParseFlag(arg, "--query_log="sv, query_log)
+            && !ParseFlag(arg, "--write_snapshot="sv, snapshot_path) && !ParseFlag(arg, "--docs="sv, documents))
+        {
+            cerr << "Unknown argument "s << arg << endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        if (!snapshot_path.empty())
+        {
+            WriteSnapshot(snapshot_path, stoi(documents));
+            return 0;
+        }
+        if (port.empty() == options.unix_socket_path.empty())
+        {
+            cerr << "Exactly one of --port and --unix is required"s << endl;
+            return 1;
+        }
+        if (!port.empty())
+        {
+            options.tcp_port = stoi(port);
+        }
+        if (!connections.empty())
+        {
+            options.connections = stoi(connections);
+        }
+        if (!pipeline.empty())
+        {
+            options.pipeline = stoi(pipeline);
+        }
+        if (!requests.empty())
+        {
+            options.requests = stoi(requests);
+        }
+        const vector<string> queries = query_log.empty() ? GenerateWorkload(WorkloadConfig{}).queries : ReadQueryLog(query_log);
+        if (queries.empty())
+        {
+            cerr << "No queries"s << endl;
+            return 1;
+        }
+
+        atomic_int next_request = 0;
+        vector<ConnectionResult> results(static_cast<size_t>(options.connections));
+        // исключение, вышедшее из потока, завершило бы процесс: оно передаётся сюда и бросается после join
+        vector<exception_ptr> failures(results.size());
+        vector<thread> threads;
+        const auto start = Clock::now();
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                try
+                {
+                    results[i] = RunConnection(options, queries, next_request);
+                }
+                catch (...)
+                {
+                    failures[i] = current_exception();
+                }
+            });
+        }
+        for (thread &thread : threads)
+        {
+            thread.join();
+        }
+        for (const exception_ptr &failure : failures)
+        {
+            if (failure)
+            {
+                rethrow_exception(failure);
+            }
+        }
+        const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+        LatencyHistogram latency;
+        uint64_t errors = 0;
+        for (const ConnectionResult &result : results)
+        {
+            for (size_t i = 0; i < latency.buckets.size(); ++i)
+            {
+                latency.buckets[i] += result.latency.buckets[i];
+            }
+            latency.count += result.latency.count;
+            latency.sum_ns += result.latency.sum_ns;
+            errors += result.errors;
+        }
+        const auto to_us = [](chrono::nanoseconds value) { return chrono::duration_cast<chrono::microseconds>(value).count(); };
+        cout << "requests: "s << latency.count << ", errors: "s << errors << endl;
+        cout << "throughput: "s << static_cast<uint64_t>(latency.count / seconds) << " req/s"s << endl;
+        cout << "latency us: p50 "s << to_us(latency.GetQuantile(0.5)) << ", p99 "s << to_us(latency.GetQuantile(0.99))
+             << ", p99.9 "s << to_us(latency.GetQuantile(0.999)) << endl;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Сервер поиска: search_rpc_server --snapshot=corpus.tsv|corpus.jsonl [--stop_words="a the"]
+//     [--max_document_id=N] (--port=7000 | --unix=/tmp/search.sock)
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "ingest.h"
+#include "rpc_server.h"
+
+using namespace std;
+
+namespace
+{
+RpcServer *running_server = nullptr;
+
+void HandleSignal(int)
+{
+    if (running_server != nullptr)
+    {
+        running_server->Stop();
+    }
+}
+
+bool ParseFlag(string_view arg, string_view name, string &value)
+{
+    if (arg.substr(0, name.size()) != name)
+    {
+        return false;
+    }
+    value = string(arg.substr(name.size()));
+    return true;
+}
+}
+
+int main(int argc, char **argv)
+{
+    string snapshot_path;
+    string stop_words;
+    string port;
+    string max_document_id;
+    RpcServerOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!ParseFlag(argv[i], "--snapshot="sv, snapshot_path) && !ParseFlag(argv[i], "--stop_words="sv, stop_words)
+            && !ParseFlag(argv[i], "--port="sv, port) && !ParseFlag(argv[i], "--unix="sv, options.unix_socket_path)
+            && !ParseFlag(argv[i], "--max_document_id="sv, max_document_id))
+        {
+            cerr << "Unknown argument "s << argv[i] << endl;
+            return 1;
+        }
+    }
+    if (port.empty() == options.unix_socket_path.empty())
+    {
+        cerr << "Exactly one of --port and --unix is required"s << endl;
+        return 1;
+    }
+
+    try
+    {
+        SearchServer server(stop_words);
+        if (!snapshot_path.empty())
+        {
+            IngestFile(server, snapshot_path).Print(cerr);
+        }
+        if (!port.empty())
+        {
+            options.tcp_port = stoi(port);
+        }
+        if (!max_document_id.empty())
+        {
+            options.limits.max_document_id = stoi(max_document_id);
+        }
+
+        RpcServer rpc_server(server, options);
+        running_server = &rpc_server;
+        signal(SIGINT, HandleSignal);
+        signal(SIGTERM, HandleSignal);
+        cerr << "Listening on "s << (port.empty() ? options.unix_socket_path : "127.0.0.1:"s + port) << endl;
+        rpc_server.Run();
+        running_server = nullptr;
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
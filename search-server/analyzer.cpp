@@ -0,0 +1,345 @@
+#include "analyzer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+struct DecodedChar
+{
+    uint32_t code_point;
+    size_t length;
+    bool is_valid;
+};
+
+// некорректная последовательность, overlong-запись и суррогаты дают is_valid == false длиной 1
+DecodedChar DecodeUtf8(std::string_view text, size_t pos)
+{
+    static const uint32_t MIN_CODE_POINT[] = {0, 0, 0x80, 0x800, 0x10000};
+
+    const unsigned char lead = static_cast<unsigned char>(text[pos]);
+    if (lead < 0x80)
+    {
+        return {lead, 1, true};
+    }
+    size_t length = 0;
+    uint32_t code_point = 0;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        length = 2;
+        code_point = lead & 0x1F;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        length = 3;
+        code_point = lead & 0x0F;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        length = 4;
+        code_point = lead & 0x07;
+    }
+    else
+    {
+        return {lead, 1, false};
+    }
+    if (pos + length > text.size())
+    {
+        return {lead, 1, false};
+    }
+    for (size_t i = 1; i < length; ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[pos + i]);
+        if ((c & 0xC0) != 0x80)
+        {
+            return {lead, 1, false};
+        }
+        code_point = (code_point << 6) | (c & 0x3F);
+    }
+    if (code_point < MIN_CODE_POINT[length] || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+    {
+        return {lead, 1, false};
+    }
+    return {code_point, length, true};
+}
+
+// по 8 байт за шаг: в ASCII старший бит каждого байта нулевой
+bool IsAscii(std::string_view text)
+{
+    uint64_t bits = 0;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= text.size(); i += sizeof(uint64_t))
+    {
+        uint64_t chunk;
+        std::memcpy(&chunk, text.data() + i, sizeof(chunk));
+        bits |= chunk;
+    }
+    for (; i < text.size(); ++i)
+    {
+        bits |= static_cast<unsigned char>(text[i]);
+    }
+    return (bits & 0x8080808080808080ull) == 0;
+}
+
+bool IsQueryOperator(uint32_t code_point, const std::string &out)
+{
+    if (code_point == '"' || code_point == '(' || code_point == ')' || code_point == '*')
+    {
+        return true;
+    }
+    // + и - - операторы только в начале слова, внутри слова это обычные символы
+    return (code_point == '+' || code_point == '-')
+           && (out.empty() || out.back() == ' ' || out.back() == '"' || out.back() == '(');
+}
+
+bool EndsWith(std::string_view word, std::string_view suffix)
+{
+    return word.size() >= suffix.size() && word.substr(word.size() - suffix.size()) == suffix;
+}
+
+// S-stemmer: срабатывает первое подходящее правило. Возвращает, сколько символов слова оставить,
+// и нужно ли дописать 'y'
+std::pair<size_t, bool> StemWord(std::string_view word)
+{
+    if (word.size() <= 3)
+    {
+        return {word.size(), false};
+    }
+    if (EndsWith(word, "ies") && !EndsWith(word, "eies") && !EndsWith(word, "aies"))
+    {
+        return {word.size() - 3, true};
+    }
+    if (EndsWith(word, "es") && !EndsWith(word, "aes") && !EndsWith(word, "ees") && !EndsWith(word, "oes"))
+    {
+        return {word.size() - 1, false};
+    }
+    if (EndsWith(word, "s") && !EndsWith(word, "us") && !EndsWith(word, "ss"))
+    {
+        return {word.size() - 1, false};
+    }
+    return {word.size(), false};
+}
+}
+
+Analyzer::Analyzer() : Analyzer(AnalyzerOptions{})
+{
+}
+
+Analyzer::Analyzer(const AnalyzerOptions &options) : options_(options)
+{
+    for (uint32_t c = 0; c < ascii_table_.size(); ++c)
+    {
+        ascii_table_[c] = IsSeparator(c) ? ' ' : static_cast<char>(FoldCase(c));
+    }
+}
+
+std::string Analyzer::NormalizeText(std::string_view text) const
+{
+    std::string result;
+    if (IsAscii(text))
+    {
+        result.resize(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            result[i] = ascii_table_[static_cast<unsigned char>(text[i])];
+        }
+    }
+    else
+    {
+        Normalize(text, false, result);
+    }
+    if (options_.stem)
+    {
+        StemWords(result, false);
+    }
+    return result;
+}
+
+std::string Analyzer::NormalizeQuery(std::string_view text) const
+{
+    std::string result;
+    Normalize(text, true, result);
+    if (options_.stem)
+    {
+        StemWords(result, true);
+    }
+    return result;
+}
+
+void Analyzer::AppendCodePoint(std::string &out, uint32_t code_point) const
+{
+    if (code_point < 0x80)
+    {
+        out.push_back(static_cast<char>(code_point));
+    }
+    else if (code_point < 0x800)
+    {
+        out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    else if (code_point < 0x10000)
+    {
+        out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+bool Analyzer::IsSeparator(uint32_t code_point) const
+{
+    if (code_point == ' ')
+    {
+        return true;
+    }
+    if (!options_.split_punctuation)
+    {
+        return false;
+    }
+    if (code_point < 0x80)
+    {
+        return !((code_point >= '0' && code_point <= '9') || (code_point >= 'a' && code_point <= 'z')
+                 || (code_point >= 'A' && code_point <= 'Z'));
+    }
+    // управляющие символы, NBSP, знаки и символы Latin-1, кроме букв ª µ º
+    if (code_point <= 0xBF)
+    {
+        return code_point != 0xAA && code_point != 0xB5 && code_point != 0xBA;
+    }
+    return code_point == 0xD7 || code_point == 0xF7
+           || (code_point >= 0x2000 && code_point <= 0x206F)  // общая пунктуация: тире, кавычки, пробелы
+           || (code_point >= 0x3000 && code_point <= 0x303F)  // пунктуация CJK
+           || (code_point >= 0xFF01 && code_point <= 0xFF0F)  // полноширинные знаки
+           || code_point == 0xFEFF;
+}
+
+uint32_t Analyzer::FoldCase(uint32_t code_point) const
+{
+    if (!options_.fold_case)
+    {
+        return code_point;
+    }
+    if (code_point < 0x80)
+    {
+        return code_point >= 'A' && code_point <= 'Z' ? code_point + 32 : code_point;
+    }
+    if (code_point >= 0xC0 && code_point <= 0xDE && code_point != 0xD7)
+    {
+        return code_point + 32;
+    }
+    if (code_point >= 0x100 && code_point <= 0x17F)
+    {
+        // в Latin Extended-A заглавная и строчная идут парами
+        if (code_point == 0x130)
+        {
+            return 'i';
+        }
+        if (code_point <= 0x137 || (code_point >= 0x14A && code_point <= 0x177))
+        {
+            return code_point | 1;
+        }
+        if ((code_point >= 0x139 && code_point <= 0x148) || (code_point >= 0x179 && code_point <= 0x17E))
+        {
+            return code_point + (code_point & 1);
+        }
+        return code_point == 0x178 ? 0xFF : code_point;
+    }
+    if (code_point >= 0x391 && code_point <= 0x3AB && code_point != 0x3A2)
+    {
+        return code_point + 32;
+    }
+    if (code_point >= 0x400 && code_point <= 0x40F)
+    {
+        return code_point + 80;
+    }
+    if (code_point >= 0x410 && code_point <= 0x42F)
+    {
+        return code_point + 32;
+    }
+    return code_point;
+}
+
+void Analyzer::Normalize(std::string_view text, bool is_query, std::string &out) const
+{
+    out.clear();
+    out.reserve(text.size());
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        const DecodedChar c = DecodeUtf8(text, pos);
+        if (!c.is_valid)
+        {
+            // байт вне UTF-8 остаётся частью слова как есть
+            out.push_back(text[pos++]);
+            continue;
+        }
+        pos += c.length;
+        if (is_query && IsQueryOperator(c.code_point, out))
+        {
+            out.push_back(static_cast<char>(c.code_point));
+        }
+        else if (IsSeparator(c.code_point))
+        {
+            out.push_back(' ');
+        }
+        else
+        {
+            AppendCodePoint(out, FoldCase(c.code_point));
+        }
+    }
+}
+
+// Слова только укорачиваются, поэтому текст переписывается на месте: позиция записи
+// никогда не обгоняет позицию чтения
+void Analyzer::StemWords(std::string &text, bool is_query) const
+{
+    size_t write = 0;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        if (text[pos] == ' ')
+        {
+            text[write++] = text[pos++];
+            continue;
+        }
+        const size_t end = std::min(text.find(' ', pos), text.size());
+        const std::string_view token(text.data() + pos, end - pos);
+        size_t core_begin = 0;
+        size_t core_end = token.size();
+        if (is_query)
+        {
+            while (core_begin < core_end && std::strchr("+-\"(", token[core_begin]) != nullptr)
+            {
+                ++core_begin;
+            }
+            while (core_end > core_begin && (token[core_end - 1] == '"' || token[core_end - 1] == ')'))
+            {
+                --core_end;
+            }
+        }
+        const std::string_view core = token.substr(core_begin, core_end - core_begin);
+        const auto [keep, append_y] = is_query && EndsWith(core, "*") ? std::pair<size_t, bool>{core.size(), false}
+                                                                       : StemWord(core);
+        for (size_t i = 0; i < core_begin + keep; ++i)
+        {
+            text[write++] = text[pos + i];
+        }
+        if (append_y)
+        {
+            text[write++] = 'y';
+        }
+        for (size_t i = core_end; i < token.size(); ++i)
+        {
+            text[write++] = text[pos + i];
+        }
+        pos = end;
+    }
+    text.resize(write);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// По умолчанию всё выключено: слова разделяются только пробелом и сравниваются побайтно
+struct AnalyzerOptions
+{
+    // нижний регистр для ASCII, Latin-1, Latin Extended-A, греческого и кириллицы
+    bool fold_case = false;
+    // пунктуация и пробельные символы Unicode тоже разделяют слова: "cat," -> "cat"
+    bool split_punctuation = false;
+    // лёгкий английский стеммер (S-stemmer Харман): cats -> cat, ponies -> pony
+    bool stem = false;
+
+    bool IsEnabled() const
+    {
+        return fold_case || split_punctuation || stem;
+    }
+};
+
+// Приводит текст документа или запроса к виду "слово слово ...", в котором слова сравниваются
+// побайтно. Текст без байтов старше 0x7F идёт по быстрому пути: один проход по таблице
+// из 128 байт без ветвлений, длина текста не меняется
+class Analyzer
+{
+public:
+    Analyzer();
+    explicit Analyzer(const AnalyzerOptions &options);
+
+    const AnalyzerOptions &GetOptions() const
+    {
+        return options_;
+    }
+
+    bool IsEnabled() const
+    {
+        return options_.IsEnabled();
+    }
+
+    std::string NormalizeText(std::string_view text) const;
+    // операторы запроса сохраняются: + и - перед словом, кавычки, скобки и *;
+    // слова с * на конце - префиксы, их стеммер не трогает
+    std::string NormalizeQuery(std::string_view text) const;
+
+private:
+    void AppendCodePoint(std::string &out, uint32_t code_point) const;
+    bool IsSeparator(uint32_t code_point) const;
+    uint32_t FoldCase(uint32_t code_point) const;
+    void Normalize(std::string_view text, bool is_query, std::string &out) const;
+    void StemWords(std::string &text, bool is_query) const;
+
+    AnalyzerOptions options_;
+    // быстрый путь для ASCII: разделители заменяются пробелом, буквы - строчными
+    std::array<char, 128> ascii_table_;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+// Очередь между стадиями конвейера: Push ждёт, пока освободится место, поэтому быстрая
+// стадия не убегает вперёд медленной. После Close Pop отдаёт остаток и затем nullopt
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity)
+    {
+    }
+
+    void Push(T value)
+    {
+        std::unique_lock lock(mutex_);
+        not_full_.wait(lock, [this]() { return items_.size() < capacity_; });
+        items_.push_back(std::move(value));
+        not_empty_.notify_one();
+    }
+
+    std::optional<T> Pop()
+    {
+        std::unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty())
+        {
+            return std::nullopt;
+        }
+        T value = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return value;
+    }
+
+    void Close()
+    {
+        std::lock_guard guard(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
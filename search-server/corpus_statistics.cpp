@@ -0,0 +1,41 @@
+#include "corpus_statistics.h"
+
+int CorpusStatistics::GetDocumentFreq(std::string_view word) const
+{
+    const auto it = document_freqs.find(word);
+    return it == document_freqs.end() ? 0 : it->second;
+}
+
+double CorpusStatistics::GetAverageDocumentLength() const
+{
+    return document_count == 0 ? 0.0 : static_cast<double>(total_document_length) / document_count;
+}
+
+void CorpusStatistics::AddDocument(const std::vector<std::string_view> &words, int length)
+{
+    ++document_count;
+    total_document_length += length;
+    for (const std::string_view word : words)
+    {
+        auto it = document_freqs.find(word);
+        if (it == document_freqs.end())
+        {
+            it = document_freqs.emplace(std::string(word), 0).first;
+        }
+        ++it->second;
+    }
+}
+
+void CorpusStatistics::RemoveDocument(const std::vector<std::string_view> &words, int length)
+{
+    --document_count;
+    total_document_length -= length;
+    for (const std::string_view word : words)
+    {
+        const auto it = document_freqs.find(word);
+        if (it != document_freqs.end() && --it->second == 0)
+        {
+            document_freqs.erase(it);
+        }
+    }
+}
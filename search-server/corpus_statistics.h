@@ -0,0 +1,24 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Статистика корпуса, общая для нескольких SearchServer: по ней шарды считают idf и среднюю
+// длину документа так же, как один сервер со всеми документами
+struct CorpusStatistics
+{
+    int document_count = 0;
+    long long total_document_length = 0;
+    // в скольких документах встречается слово
+    std::map<std::string, int, std::less<>> document_freqs;
+
+    int GetDocumentFreq(std::string_view word) const;
+    double GetAverageDocumentLength() const;
+
+    // words - различные слова документа, length - число слов без стоп-слов
+    void AddDocument(const std::vector<std::string_view> &words, int length);
+    void RemoveDocument(const std::vector<std::string_view> &words, int length);
+};
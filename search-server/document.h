@@ -29,10 +29,14 @@ enum class DocumentStatus
     REMOVED,
 };
 
+const int DOCUMENT_STATUS_COUNT = 4;
+
 struct DocumentData
 {
     int rating;
     DocumentStatus status;
+    // место документа в плотных колонках сервера
+    int slot;
 };
 
 std::ostream &operator<<(std::ostream &out, const DocumentStatus &status);
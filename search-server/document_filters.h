@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+// Фильтры, которые SearchServer распознаёт на этапе компиляции и проверяет по колонкам
+// статусов и рейтингов без вызова общего предиката. Их можно передавать и как обычный
+// предикат (document_id, status, rating).
+
+struct StatusFilter
+{
+    DocumentStatus status;
+
+    bool operator()([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) const
+    {
+        return document_status == status;
+    }
+};
+
+// Границы включаются
+struct RatingRangeFilter
+{
+    int min_rating;
+    int max_rating;
+
+    bool Contains(int rating) const
+    {
+        return rating >= min_rating && rating <= max_rating;
+    }
+
+    bool operator()([[maybe_unused]] int document_id, [[maybe_unused]] DocumentStatus status, int rating) const
+    {
+        return Contains(rating);
+    }
+};
+
+class IdSetFilter
+{
+public:
+    // отсортированный список, а не битовая карта по id: память не зависит от величины id
+    explicit IdSetFilter(std::vector<int> document_ids)
+    {
+        std::sort(document_ids.begin(), document_ids.end());
+        document_ids.erase(std::unique(document_ids.begin(), document_ids.end()), document_ids.end());
+        members_ = std::make_shared<const std::vector<int>>(std::move(document_ids));
+    }
+
+    bool Contains(int document_id) const
+    {
+        return std::binary_search(members_->begin(), members_->end(), document_id);
+    }
+
+    bool operator()(int document_id, [[maybe_unused]] DocumentStatus status, [[maybe_unused]] int rating) const
+    {
+        return Contains(document_id);
+    }
+
+private:
+    // разделяется между копиями: предикаты передаются по значению
+    std::shared_ptr<const std::vector<int>> members_;
+};
@@ -0,0 +1,242 @@
+#include "generators.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace std;
+
+ZipfDistribution::ZipfDistribution(size_t size, double skew)
+{
+    if (size == 0)
+    {
+        throw invalid_argument("Zipf distribution needs at least one rank");
+    }
+    cumulative_.reserve(size);
+    double total = 0;
+    for (size_t rank = 0; rank < size; ++rank)
+    {
+        total += 1.0 / pow(static_cast<double>(rank + 1), skew);
+        cumulative_.push_back(total);
+    }
+    for (double &value : cumulative_)
+    {
+        value /= total;
+    }
+}
+
+size_t ZipfDistribution::operator()(mt19937 &generator) const
+{
+    const double point = uniform_real_distribution<>(0, 1)(generator);
+    const auto it = upper_bound(cumulative_.begin(), cumulative_.end(), point);
+    return min(static_cast<size_t>(it - cumulative_.begin()), cumulative_.size() - 1);
+}
+
+string GenerateWord(mt19937& generator, int max_length) {
+    const int length = uniform_int_distribution(1, max_length)(generator);
+    string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
+    vector<string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+string GenerateQuery(mt19937& generator, const vector<string>& dictionary, const ZipfDistribution& word_distribution,
+                     int word_count, double minus_prob) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[word_distribution(generator) % dictionary.size()];
+    }
+    return query;
+}
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, const ZipfDistribution& word_distribution,
+                               int query_count, int word_count, double minus_prob) {
+    vector<string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, word_distribution, word_count, minus_prob));
+    }
+    return queries;
+}
+
+namespace
+{
+vector<string> GenerateUniqueWords(mt19937 &generator, int word_count, int max_length)
+{
+    vector<string> words;
+    unordered_set<string> seen;
+    words.reserve(word_count);
+    // короткие слова быстро кончаются, поэтому попытки ограничены
+    for (int attempt = 0; static_cast<int>(words.size()) < word_count && attempt < word_count * 10; ++attempt)
+    {
+        string word = GenerateWord(generator, max_length);
+        if (seen.insert(word).second)
+        {
+            words.push_back(move(word));
+        }
+    }
+    return words;
+}
+}
+
+string Workload::GetStopWordsText() const
+{
+    string result;
+    for (const string &word : stop_words)
+    {
+        if (!result.empty())
+        {
+            result.push_back(' ');
+        }
+        result += word;
+    }
+    return result;
+}
+
+Workload GenerateWorkload(const WorkloadConfig &config, uint32_t seed)
+{
+    if (config.dictionary_size < 1)
+    {
+        throw invalid_argument("Workload needs at least one dictionary word");
+    }
+    mt19937 generator(seed);
+    Workload workload;
+    workload.dictionary = GenerateUniqueWords(generator, config.dictionary_size, config.max_word_length);
+
+    // слова идут по убыванию частоты: первые stop_word_count становятся стоп-словами
+    const size_t stop_word_count = min<size_t>(max(config.stop_word_count, 0), workload.dictionary.size() - 1);
+    workload.stop_words.assign(workload.dictionary.begin(), workload.dictionary.begin() + stop_word_count);
+    const vector<string> content_words(workload.dictionary.begin() + stop_word_count, workload.dictionary.end());
+    const ZipfDistribution word_distribution(content_words.size(), config.zipf_skew);
+
+    lognormal_distribution<> length_distribution(log(max(config.median_document_length, 1)), config.document_length_sigma);
+    workload.documents.reserve(config.document_count);
+    for (int i = 0; i < config.document_count; ++i)
+    {
+        const int length = clamp(static_cast<int>(length_distribution(generator)), 1, config.max_document_length);
+        string document;
+        for (int j = 0; j < length; ++j)
+        {
+            if (!document.empty())
+            {
+                document.push_back(' ');
+            }
+            if (stop_word_count > 0 && uniform_real_distribution<>(0, 1)(generator) < config.stop_word_share)
+            {
+                document += workload.stop_words[uniform_int_distribution<size_t>(0, stop_word_count - 1)(generator)];
+            }
+            else
+            {
+                document += content_words[word_distribution(generator)];
+            }
+        }
+        workload.documents.push_back(move(document));
+    }
+
+    const auto generate_query = [&]()
+    {
+        const int word_count = uniform_int_distribution(1, max(config.max_query_word_count, 1))(generator);
+        return GenerateQuery(generator, content_words, word_distribution, word_count, config.minus_prob);
+    };
+    vector<string> hot_queries;
+    for (int i = 0; i < config.hot_query_count; ++i)
+    {
+        hot_queries.push_back(generate_query());
+    }
+    workload.queries.reserve(config.query_count);
+    if (hot_queries.empty())
+    {
+        for (int i = 0; i < config.query_count; ++i)
+        {
+            workload.queries.push_back(generate_query());
+        }
+        return workload;
+    }
+    const ZipfDistribution hot_distribution(hot_queries.size(), 1.0);
+    for (int i = 0; i < config.query_count; ++i)
+    {
+        if (uniform_real_distribution<>(0, 1)(generator) < config.hot_query_share)
+        {
+            workload.queries.push_back(hot_queries[hot_distribution(generator)]);
+        }
+        else
+        {
+            workload.queries.push_back(generate_query());
+        }
+    }
+    return workload;
+}
+
+vector<string> ReadQueryLog(istream &input)
+{
+    vector<string> queries;
+    string line;
+    while (getline(input, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(' ') != string::npos)
+        {
+            queries.push_back(move(line));
+        }
+    }
+    return queries;
+}
+
+vector<string> ReadQueryLog(const string &path)
+{
+    ifstream input(path);
+    if (!input)
+    {
+        throw runtime_error("Can't open query log "s + path);
+    }
+    return ReadQueryLog(input);
+}
+
+void WriteQueryLog(ostream &output, const vector<string> &queries)
+{
+    for (const string &query : queries)
+    {
+        output << query << '\n';
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Распределение Ципфа по рангам 0..size-1: P(rank) ~ 1 / (rank + 1)^skew.
+// skew = 0 - равномерное распределение.
+class ZipfDistribution
+{
+public:
+    ZipfDistribution(size_t size, double skew);
+
+    size_t operator()(std::mt19937 &generator) const;
+
+    size_t GetSize() const
+    {
+        return cumulative_.size();
+    }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+std::string GenerateWord(std::mt19937 &generator, int max_length);
+std::vector<std::string> GenerateDictionary(std::mt19937 &generator, int word_count, int max_length);
+
+std::string GenerateQuery(std::mt19937 &generator, const std::vector<std::string> &dictionary, int word_count, double minus_prob = 0);
+std::string GenerateQuery(std::mt19937 &generator, const std::vector<std::string> &dictionary,
+                          const ZipfDistribution &word_distribution, int word_count, double minus_prob = 0);
+
+std::vector<std::string> GenerateQueries(std::mt19937 &generator, const std::vector<std::string> &dictionary, int query_count, int max_word_count);
+std::vector<std::string> GenerateQueries(std::mt19937 &generator, const std::vector<std::string> &dictionary,
+                                         const ZipfDistribution &word_distribution, int query_count, int word_count,
+                                         double minus_prob = 0);
+
+struct WorkloadConfig
+{
+    int dictionary_size = 10'000;
+    int max_word_length = 10;
+    // перекос частот слов в документах и запросах
+    double zipf_skew = 1.0;
+
+    int document_count = 10'000;
+    // длина документа распределена логнормально с медианой median_document_length
+    int median_document_length = 50;
+    double document_length_sigma = 0.6;
+    int max_document_length = 1'000;
+
+    // стоп-слова - stop_word_count самых частых слов словаря, stop_word_share - их доля в тексте
+    int stop_word_count = 20;
+    double stop_word_share = 0.2;
+
+    int query_count = 1'000;
+    int max_query_word_count = 5;
+    double minus_prob = 0.1;
+    // доля запросов, взятых из небольшого набора популярных (с перекосом Ципфа внутри набора)
+    int hot_query_count = 50;
+    double hot_query_share = 0.3;
+};
+
+struct Workload
+{
+    std::vector<std::string> dictionary;
+    std::vector<std::string> stop_words;
+    std::vector<std::string> documents;
+    std::vector<std::string> queries;
+
+    std::string GetStopWordsText() const;
+};
+
+Workload GenerateWorkload(const WorkloadConfig &config, uint32_t seed = 42);
+
+// Журнал запросов: один запрос на строку, пустые строки пропускаются
+std::vector<std::string> ReadQueryLog(std::istream &input);
+std::vector<std::string> ReadQueryLog(const std::string &path);
+void WriteQueryLog(std::ostream &output, const std::vector<std::string> &queries);
@@ -0,0 +1,78 @@
+#include "index_statistics.h"
+
+#include <algorithm>
+
+int IndexStatistics::GetPostingLengthBucket(size_t posting_length)
+{
+    int bucket = 0;
+    while (posting_length > 1)
+    {
+        posting_length >>= 1;
+        ++bucket;
+    }
+    return std::min(bucket, POSTING_LENGTH_BUCKET_COUNT - 1);
+}
+
+void IndexStatistics::AddPosting(size_t new_length)
+{
+    ++posting_count;
+    if (new_length == 1)
+    {
+        ++term_count;
+    }
+    else
+    {
+        --posting_length_histogram[GetPostingLengthBucket(new_length - 1)];
+    }
+    ++posting_length_histogram[GetPostingLengthBucket(new_length)];
+}
+
+void IndexStatistics::RemovePosting(size_t new_length)
+{
+    RemovePostings(new_length + 1, new_length);
+}
+
+void IndexStatistics::RemovePostings(size_t old_length, size_t new_length)
+{
+    if (old_length == new_length)
+    {
+        return;
+    }
+    posting_count -= old_length - new_length;
+    --posting_length_histogram[GetPostingLengthBucket(old_length)];
+    if (new_length == 0)
+    {
+        --term_count;
+    }
+    else
+    {
+        ++posting_length_histogram[GetPostingLengthBucket(new_length)];
+    }
+}
+
+size_t IndexStatistics::GetTotalBytes() const
+{
+    return dictionary_bytes + posting_bytes + forward_index_bytes + position_bytes + document_text_bytes
+           + stop_word_bytes + impact_index_bytes + column_bytes;
+}
+
+void IndexStatistics::Print(std::ostream &out) const
+{
+    out << document_count << " documents, " << term_count << " terms (" << dictionary_size << " in dictionary), "
+        << posting_count << " postings, " << token_count << " tokens" << std::endl;
+    out << "KiB: dictionary " << dictionary_bytes / 1024 << ", postings " << posting_bytes / 1024
+        << ", forward index " << forward_index_bytes / 1024 << ", positions " << position_bytes / 1024
+        << ", texts " << document_text_bytes / 1024 << ", stop words " << stop_word_bytes / 1024
+        << ", impact index " << impact_index_bytes / 1024 << ", columns " << column_bytes / 1024
+        << ", total " << GetTotalBytes() / 1024 << std::endl;
+    out << "posting lengths:";
+    for (int bucket = 0; bucket < POSTING_LENGTH_BUCKET_COUNT; ++bucket)
+    {
+        if (posting_length_histogram[bucket] > 0)
+        {
+            out << " [" << (size_t{1} << bucket) << ", " << (size_t{1} << (bucket + 1)) << "): "
+                << posting_length_histogram[bucket];
+        }
+    }
+    out << std::endl;
+}
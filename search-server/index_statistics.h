@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+
+// Размер индекса для планирования шардов. Счётчики поддерживает сам SearchServer при
+// добавлении и удалении документов, поэтому GetIndexStatistics не обходит индекс
+struct IndexStatistics
+{
+    static const int POSTING_LENGTH_BUCKET_COUNT = 32;
+
+    int document_count = 0;
+    // слова, у которых есть хотя бы один постинг
+    size_t term_count = 0;
+    // все ключи словаря, включая слова, оставшиеся без постингов после удаления документов
+    size_t dictionary_size = 0;
+    size_t posting_count = 0;
+    // слова всех документов с повторами и стоп-словами: по ним проверяются фразы
+    size_t token_count = 0;
+
+    // байты: узлы словаря, постингов и прямого индекса - по счётчикам пулов, остальное - по
+    // ёмкости контейнеров. Тексты удалённых документов сервер не освобождает, они остаются в document_text_bytes
+    size_t dictionary_bytes = 0;
+    size_t posting_bytes = 0;
+    size_t forward_index_bytes = 0;
+    size_t position_bytes = 0;
+    size_t document_text_bytes = 0;
+    size_t stop_word_bytes = 0;
+    size_t impact_index_bytes = 0;
+    size_t column_bytes = 0;
+
+    // posting_length_histogram[i] - число слов, у которых от 2^i до 2^(i + 1) - 1 постингов
+    std::array<size_t, POSTING_LENGTH_BUCKET_COUNT> posting_length_histogram{};
+
+    static int GetPostingLengthBucket(size_t posting_length);
+
+    // вызываются после изменения списка постингов слова, new_length - его новая длина
+    void AddPosting(size_t new_length);
+    void RemovePosting(size_t new_length);
+    // из списка слова удалено сразу old_length - new_length постингов
+    void RemovePostings(size_t old_length, size_t new_length);
+
+    size_t GetTotalBytes() const;
+    void Print(std::ostream &out) const;
+};
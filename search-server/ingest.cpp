@@ -0,0 +1,241 @@
+#include "ingest.h"
+
+#include <future>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif
+
+#include "bounded_queue.h"
+#include "snapshot.h"
+
+namespace
+{
+// Файл целиком в памяти: mmap там, где он есть, иначе чтение одним куском
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path)
+    {
+#ifdef __unix__
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat info{};
+        if (fstat(fd, &info) < 0)
+        {
+            close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0)
+        {
+            void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                close(fd);
+                throw std::runtime_error("cannot mmap " + path);
+            }
+            madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char *>(data);
+        }
+        close(fd);
+#else
+        std::ifstream input(path, std::ios::binary);
+        if (!input)
+        {
+            throw std::runtime_error("cannot open " + path);
+        }
+        std::ostringstream buffer;
+        buffer << input.rdbuf();
+        contents_ = buffer.str();
+        data_ = contents_.data();
+        size_ = contents_.size();
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef __unix__
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<char *>(data_), size_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string_view GetContents() const
+    {
+        return {data_, size_};
+    }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+#ifndef __unix__
+    std::string contents_;
+#endif
+};
+
+struct ParsedBatch
+{
+    std::vector<TokenizedDocument> documents;
+    size_t rejected = 0;
+    std::string first_error;
+};
+
+struct LineBatch
+{
+    std::vector<std::string_view> lines;
+    std::promise<ParsedBatch> result;
+};
+
+bool EndsWith(const std::string &text, std::string_view suffix)
+{
+    return text.size() >= suffix.size() && std::string_view(text).substr(text.size() - suffix.size()) == suffix;
+}
+}
+
+double IngestStats::GetDocumentsPerSecond() const
+{
+    const double seconds = std::chrono::duration<double>(duration).count();
+    return seconds > 0 ? documents / seconds : 0.0;
+}
+
+void IngestStats::Print(std::ostream &out) const
+{
+    out << "Ingested " << documents << " documents (" << bytes / (1 << 20) << " MiB) in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << " ms, "
+        << static_cast<uint64_t>(GetDocumentsPerSecond()) << " docs/s";
+    if (rejected > 0)
+    {
+        out << ", rejected " << rejected << " (first: " << first_error << ")";
+    }
+    out << std::endl;
+}
+
+IngestStats IngestFile(SearchServer &server, const std::string &path, const IngestOptions &options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const MappedFile file(path);
+    const bool is_json = options.format == IngestFormat::JSONL
+                         || (options.format == IngestFormat::AUTO && EndsWith(path, ".jsonl"));
+    const size_t thread_count = options.parse_threads > 0 ? options.parse_threads
+                                                          : std::max(1u, std::thread::hardware_concurrency());
+    const size_t batch_size = std::max<size_t>(1, options.batch_size);
+    const size_t max_batches_in_flight = std::max<size_t>(1, options.max_batches_in_flight);
+
+    // пачки на разбор и результаты в порядке файла; вторая очередь ограничивает число пачек в работе
+    BoundedQueue<std::shared_ptr<LineBatch>> parse_queue(max_batches_in_flight);
+    BoundedQueue<std::future<ParsedBatch>> insert_queue(max_batches_in_flight);
+
+    std::vector<std::thread> parsers;
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        parsers.emplace_back([&]()
+        {
+            while (auto batch = parse_queue.Pop())
+            {
+                ParsedBatch parsed;
+                parsed.documents.reserve((*batch)->lines.size());
+                for (const std::string_view line : (*batch)->lines)
+                {
+                    try
+                    {
+                        SnapshotRecord record = is_json ? ParseJsonSnapshotLine(line) : ParseSnapshotLine(line);
+                        parsed.documents.push_back(server.TokenizeDocument(record.id, std::move(record.text), record.status,
+                                                                           std::move(record.ratings)));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        if (parsed.rejected++ == 0)
+                        {
+                            parsed.first_error = e.what();
+                        }
+                    }
+                }
+                (*batch)->result.set_value(std::move(parsed));
+            }
+        });
+    }
+
+    std::thread reader([&]()
+    {
+        std::string_view contents = file.GetContents();
+        while (!contents.empty())
+        {
+            auto batch = std::make_shared<LineBatch>();
+            batch->lines.reserve(batch_size);
+            while (!contents.empty() && batch->lines.size() < batch_size)
+            {
+                const size_t end = std::min(contents.find('\n'), contents.size());
+                if (end > 0)
+                {
+                    batch->lines.push_back(contents.substr(0, end));
+                }
+                contents.remove_prefix(std::min(contents.size(), end + 1));
+            }
+            insert_queue.Push(batch->result.get_future());
+            parse_queue.Push(std::move(batch));
+        }
+        parse_queue.Close();
+        insert_queue.Close();
+    });
+
+    IngestStats stats;
+    stats.bytes = file.GetContents().size();
+    const auto reject = [&stats](std::string error)
+    {
+        if (stats.rejected++ == 0)
+        {
+            stats.first_error = std::move(error);
+        }
+    };
+    while (auto result = insert_queue.Pop())
+    {
+        ParsedBatch batch = result->get();
+        if (batch.rejected > 0)
+        {
+            if (stats.rejected == 0)
+            {
+                stats.first_error = batch.first_error;
+            }
+            stats.rejected += batch.rejected;
+        }
+        for (TokenizedDocument &document : batch.documents)
+        {
+            try
+            {
+                server.AddDocument(std::move(document));
+                ++stats.documents;
+            }
+            catch (const std::exception &e)
+            {
+                reject(e.what());
+            }
+        }
+    }
+
+    reader.join();
+    for (std::thread &parser : parsers)
+    {
+        parser.join();
+    }
+    stats.duration = std::chrono::steady_clock::now() - start;
+    return stats;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "search_server.h"
+
+enum class IngestFormat
+{
+    // .jsonl - JSONL, остальные - TSV, см. snapshot.h
+    AUTO,
+    TSV,
+    JSONL,
+};
+
+struct IngestOptions
+{
+    IngestFormat format = IngestFormat::AUTO;
+    // потоков разбора и токенизации; 0 - по числу ядер
+    size_t parse_threads = 0;
+    // строк в пачке, которая переходит между стадиями целиком
+    size_t batch_size = 1024;
+    // пачек, ожидающих разбора или вставки (не меньше одной); больше - читатель ждёт
+    size_t max_batches_in_flight = 16;
+};
+
+struct IngestStats
+{
+    size_t documents = 0;
+    // строки с ошибкой разбора или повторным id пропускаются
+    size_t rejected = 0;
+    std::string first_error;
+    size_t bytes = 0;
+    std::chrono::nanoseconds duration{};
+
+    double GetDocumentsPerSecond() const;
+    void Print(std::ostream &out) const;
+};
+
+// Конвейер: файл отображается в память и режется на пачки строк, пачки разбираются и
+// токенизируются параллельно, а вставляются в индекс одним потоком в порядке файла.
+// Строки не копируются: единственная копия текста - та, что остаётся в сервере
+IngestStats IngestFile(SearchServer &server, const std::string &path, const IngestOptions &options = {});
@@ -15,6 +15,14 @@
 #include "paginator.h"
 #include "read_input_functions.h"
 #include "process_queries.h"
+#include "remove_duplicates.h"
+#include "generators.h"
+#include "sharded_search_server.h"
+#include "rpc_protocol.h"
+#include "snapshot.h"
+#include "ingest.h"
+#include <filesystem>
+#include <fstream>
 
 #include "process_queries.h"
 #include "search_server.h"
@@ -25,16 +33,42 @@
 
 
 #include <random>
+#include <sstream>
+#include <thread>
 #include "log_duration.h"
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "rpc_server.h"
+#endif
+
 using namespace std;
 
 
 
+// целые разной знаковости сравниваются по значению, как std::cmp_equal: -1 не равно SIZE_MAX
+template<typename T, typename U>
+bool AreEqual(const T &t, const U &u) {
+    if constexpr (is_integral_v<T> && is_integral_v<U> && !is_same_v<T, bool> && !is_same_v<U, bool>
+                  && is_signed_v<T> != is_signed_v<U>) {
+        if constexpr (is_signed_v<T>) {
+            return t >= 0 && static_cast<make_unsigned_t<T>>(t) == u;
+        } else {
+            return u >= 0 && t == static_cast<make_unsigned_t<U>>(u);
+        }
+    } else {
+        return t == u;
+    }
+}
+
 template<typename T, typename U>
 void AssertEqualImpl(const T &t, const U &u, const string &t_str, const string &u_str, const string &file,
                      const string &func, unsigned line, const string &hint) {
-    if (t != u) {
+    if (!AreEqual(t, u)) {
         cout << boolalpha;
         cout << file << "("s << line << "): "s << func << ": "s;
         cout << "ASSERT_EQUAL("s << t_str << ", "s << u_str << ") failed: "s;
@@ -89,7 +123,7 @@ void TestAddDocument() {
         server.AddDocument(doc_id, content, DocumentStatus::ACTUAL, ratings);
         ASSERT_EQUAL(server.GetDocumentCount(), 1);
         const auto found_docs = server.FindTopDocuments("cat in the city"s);
-        ASSERT_EQUAL(found_docs.size(), 1);
+        ASSERT_EQUAL(found_docs.size(), 1u);
         const Document &doc0 = found_docs[0];
         ASSERT_EQUAL(doc0.id, doc_id);
     }
@@ -351,99 +385,1317 @@ void TestExcludeStopWordsFromAddedDocumentContent() {
     }
 }
 
-void TestSearchServer() {
-    RUN_TEST(TestSplitWords);
-    RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
-    RUN_TEST(TestAddDocument);
-    RUN_TEST(TestMinusWords);
-    RUN_TEST(TestMatchedDocuments);
-    RUN_TEST(TestSortFindedDocumentsByRelevance);
-    RUN_TEST(TestRatings);
-    RUN_TEST(TestRelevances);
-    RUN_TEST(TestSearchByStatus);
-    RUN_TEST(TestSearchByPredicate);
+void TestFindTopDocumentsAsync() {
+    SearchServer server("и в на"s);
+    server.AddDocument(0, "white cat and fancy collar"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "soigne dog expressive eyes"s, DocumentStatus::BANNED, {5, -12, 2});
+
+    {
+        auto future = server.FindTopDocumentsAsync("fluffy cat"s, QueryDeadline::After(1h));
+        const SearchResult result = future.get();
+        ASSERT(!result.is_partial);
+        ASSERT_EQUAL(result.documents.size(), 2);
+        ASSERT_EQUAL(result.documents[0].id, 1);
+    }
+    {
+        auto future = server.FindTopDocumentsAsync("dog"s, QueryDeadline{}, DocumentStatus::BANNED);
+        const SearchResult result = future.get();
+        ASSERT(!result.is_partial);
+        ASSERT_EQUAL(result.documents.size(), 1);
+    }
+    {
+        QueryDeadline deadline;
+        deadline.token.Cancel();
+        const SearchResult result = server.FindTopDocumentsUntil(deadline, "fluffy cat"s);
+        ASSERT(result.is_partial);
+        ASSERT(result.documents.empty());
+    }
 }
 
+void TestRequestStats() {
+    using namespace std::chrono;
+    RequestStats stats;
+    const RequestStats::Clock::time_point start = RequestStats::Clock::time_point(hours(24 * 365));
 
-void RemoveDuplicates(SearchServer &search_server) {
+    stats.Record(0, microseconds(10), start);
+    stats.Record(3, microseconds(100), start + seconds(30));
+    stats.Record(0, microseconds(1000), start + minutes(30));
+    {
+        const auto snapshot = stats.GetSnapshot(StatsWindow::MINUTE, start + seconds(59));
+        ASSERT_EQUAL(snapshot.requests, 2u);
+        ASSERT_EQUAL(snapshot.no_result_requests, 1u);
+        ASSERT_EQUAL(snapshot.result_count_histogram[3], 1u);
+    }
+    {
+        const auto snapshot = stats.GetSnapshot(StatsWindow::HOUR, start + minutes(30));
+        ASSERT_EQUAL(snapshot.requests, 3u);
+        ASSERT_EQUAL(snapshot.no_result_requests, 2u);
+        ASSERT(snapshot.GetLatencyQuantile(1.0) >= microseconds(1000));
+        ASSERT(snapshot.GetLatencyQuantile(0.0) <= microseconds(16));
+    }
+    {
+        // через сутки слот первой минуты переиспользуется
+        stats.Record(1, microseconds(10), start + hours(24));
+        const auto snapshot = stats.GetSnapshot(StatsWindow::DAY, start + hours(24));
+        ASSERT_EQUAL(snapshot.requests, 2u);
+        ASSERT_EQUAL(snapshot.no_result_requests, 1u);
+    }
 
-    vector<int> documents_to_remove;
+    SearchServer server("and in at"s);
+    server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    RequestQueue request_queue(server);
+    vector<string> queries(1000, "empty request"s);
+    queries.push_back("curly cat"s);
+    for_each(execution::par, queries.begin(), queries.end(), [&request_queue](const string &query) {
+        request_queue.AddFindRequest(query);
+    });
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1000);
+    ASSERT_EQUAL(request_queue.GetStats(StatsWindow::DAY).requests, 1001u);
+}
 
-    map<set<string_view>, int> words2doc_id;
-    set<string_view> words_in_doc;
-    for (int document_id: search_server) {
-        words_in_doc.clear();
-        for (const auto [word, freqs]: search_server.GetWordFrequencies(document_id)) {
-            words_in_doc.insert(word);
+void TestPaginator() {
+    {
+        const vector<int> numbers = {1, 2, 3, 4, 5, 6, 7};
+        const auto pages = Paginate(numbers, 3);
+        ASSERT_EQUAL(pages.GetPageCount(), 3u);
+        ASSERT_EQUAL(pages.GetPage(1).size(), 3);
+        ASSERT_EQUAL(*pages.GetPage(2).begin, 7);
+        ASSERT_EQUAL(pages.GetPage(5).size(), 0);
+        vector<int> sizes;
+        for (const auto &page : pages) {
+            sizes.push_back(page.size());
+        }
+        ASSERT(sizes == vector<int>({3, 3, 1}));
+    }
+    {
+        const list<int> numbers = {1, 2, 3, 4};
+        const auto pages = Paginate(numbers, 2);
+        ASSERT_EQUAL(pages.GetPageCount(), 2u);
+        ASSERT_EQUAL(*pages.GetPage(1).begin, 3);
+        ASSERT_EQUAL(distance(pages.begin(), pages.end()), 2);
+    }
+    {
+        SearchServer server(""s);
+        for (int id = 0; id < 10; ++id) {
+            server.AddDocument(id, "cat"s, DocumentStatus::ACTUAL, {id});
         }
+        const auto page = server.FindTopDocumentsPage("cat"s, 1, 3);
+        ASSERT_EQUAL(page.size(), 3u);
+        ASSERT_EQUAL(page[0].rating, 6);
+        ASSERT_EQUAL(page[2].rating, 4);
+        ASSERT(server.FindTopDocumentsPage("cat"s, 4, 3).empty());
+    }
+}
 
-        if (words2doc_id.count(words_in_doc) == 0) {
-            words2doc_id[words_in_doc] = document_id;
-        } else {
+void TestRemoveDuplicates() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(7, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+
+    ASSERT(FindDuplicates(search_server) == vector<int>({3, 4, 5, 7}));
+
+    DuplicateDetectorOptions near;
+    near.similarity_threshold = 0.5;
+    const auto near_duplicates = FindDuplicates(search_server, near);
+    // "funny pet and not very nasty rat" похож на "funny pet and nasty rat" (Жаккар 4/6)
+    ASSERT(count(near_duplicates.begin(), near_duplicates.end(), 6) == 1);
+    ASSERT(count(near_duplicates.begin(), near_duplicates.end(), 2) == 0);
+
+    DuplicateDetector detector;
+    SearchServer filtered("and with"s);
+    ASSERT(AddDocumentUnlessDuplicate(filtered, detector, 1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1}));
+    ASSERT(!AddDocumentUnlessDuplicate(filtered, detector, 2, "nasty rat and funny pet"s, DocumentStatus::ACTUAL, {1}));
+    ASSERT(AddDocumentUnlessDuplicate(filtered, detector, 3, "nasty rat"s, DocumentStatus::ACTUAL, {1}));
+    ASSERT_EQUAL(filtered.GetDocumentCount(), 2);
+    // после удаления тот же текст снова принимается
+    RemoveDocument(filtered, detector, 1);
+    ASSERT(!detector.Erase(1));
+    ASSERT(AddDocumentUnlessDuplicate(filtered, detector, 2, "nasty rat and funny pet"s, DocumentStatus::ACTUAL, {1}));
+    ASSERT_EQUAL(filtered.GetDocumentCount(), 2);
+
+    DuplicateDetector near_detector(near);
+    SearchServer near_filtered("and with"s);
+    ASSERT(AddDocumentUnlessDuplicate(near_filtered, near_detector, 1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1}));
+    ASSERT(!AddDocumentUnlessDuplicate(near_filtered, near_detector, 2, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1}));
+    RemoveDocument(near_filtered, near_detector, 1);
+    ASSERT(AddDocumentUnlessDuplicate(near_filtered, near_detector, 2, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1}));
+    ASSERT(!AddDocumentUnlessDuplicate(near_filtered, near_detector, 3, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1}));
+}
+
+void TestMetrics() {
+    ASSERT_EQUAL(LatencyHistogram::GetBucket(5), 5);
+    for (uint64_t value : {8ull, 9ull, 1000ull, 123456789ull}) {
+        const int bucket = LatencyHistogram::GetBucket(value);
+        ASSERT(LatencyHistogram::GetBucketUpperBound(bucket) >= value);
+        ASSERT(LatencyHistogram::GetBucketUpperBound(bucket - 1) < value);
+    }
+
+    SearchServer server("и в на"s);
+    Metrics::Reset();
+    server.AddDocument(0, "white cat and fancy collar"s, DocumentStatus::ACTUAL, {8, -3});
+    server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(Metrics::Collect().Get(MetricCounter::QUERIES), 0u);
+
+    Metrics::SetEnabled(true);
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.FindTopDocuments("cat -tail"s);
+    thread([&server] { server.FindTopDocuments("cat"s); }).join();
+    server.RemoveDocument(1);
+    Metrics::SetEnabled(false);
+
+    const MetricsSnapshot snapshot = Metrics::Collect();
+    ASSERT_EQUAL(snapshot.Get(MetricCounter::QUERIES), 2u);
+    ASSERT_EQUAL(snapshot.Get(MetricCounter::POSTINGS_VISITED), 4u);
+    ASSERT_EQUAL(snapshot.Get(MetricCounter::DOCUMENTS_SCORED), 4u);
+    ASSERT_EQUAL(snapshot.Get(MetricPhase::ADD_DOCUMENT).count, 1u);
+    ASSERT_EQUAL(snapshot.Get(MetricPhase::REMOVE_DOCUMENT).count, 1u);
+    ASSERT_EQUAL(snapshot.Get(MetricPhase::PARSE).count, 2u);
+
+    ostringstream prometheus;
+    snapshot.PrintPrometheus(prometheus);
+    ASSERT(prometheus.str().find("search_server_queries_total 2"s) != string::npos);
+    ASSERT(prometheus.str().find("search_server_phase_duration_seconds_count{phase=\"top_k\"} 2"s) != string::npos);
+
+    // данные завершившихся потоков сохраняются, а их ячейки переиспользуются
+    Metrics::SetEnabled(true);
+    const size_t slot_count = Metrics::GetThreadSlotCount();
+    for (int i = 0; i < 20; ++i) {
+        thread([] { Metrics::Increment(MetricCounter::QUERIES); }).join();
+    }
+    Metrics::SetEnabled(false);
+    ASSERT_EQUAL(Metrics::Collect().Get(MetricCounter::QUERIES), 22u);
+    ASSERT(Metrics::GetThreadSlotCount() <= slot_count + 1);
+    Metrics::Reset();
+}
 
-            documents_to_remove.push_back(document_id);
+void TestWorkloadGenerator() {
+    WorkloadConfig config;
+    config.dictionary_size = 500;
+    config.document_count = 200;
+    config.query_count = 300;
+    config.hot_query_count = 5;
+    config.hot_query_share = 0.5;
+    const Workload workload = GenerateWorkload(config, 7);
+
+    ASSERT_EQUAL(workload.documents.size(), 200u);
+    ASSERT_EQUAL(workload.queries.size(), 300u);
+    ASSERT_EQUAL(workload.stop_words.size(), 20u);
+
+    SearchServer server(workload.GetStopWordsText());
+    for (size_t id = 0; id < workload.documents.size(); ++id) {
+        server.AddDocument(static_cast<int>(id), workload.documents[id], DocumentStatus::ACTUAL, {1});
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 200);
+
+    map<string, int> query_counts;
+    for (const string &query : workload.queries) {
+        ++query_counts[query];
+    }
+    const int max_repeats = max_element(query_counts.begin(), query_counts.end(),
+                                        [](const auto &lhs, const auto &rhs) { return lhs.second < rhs.second; })->second;
+    ASSERT(max_repeats > 10);
+    ASSERT(GenerateWorkload(config, 7).queries == workload.queries);
+
+    stringstream log;
+    WriteQueryLog(log, workload.queries);
+    log << "\n   \n"s;
+    ASSERT(ReadQueryLog(log) == workload.queries);
+
+    config.dictionary_size = 0;
+    try {
+        GenerateWorkload(config, 7);
+        ASSERT_HINT(false, "Empty dictionary must be rejected"s);
+    } catch (const invalid_argument &) {
+    }
+}
+
+void TestQueryProfile() {
+    SearchServer server("и в на"s);
+    server.AddDocument(0, "white cat and fancy collar"s, DocumentStatus::ACTUAL, {8, -3});
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    server.AddDocument(2, "soigne dog expressive eyes"s, DocumentStatus::ACTUAL, {5, -12, 2});
+    server.AddDocument(3, "soigne cat eugeny"s, DocumentStatus::BANNED, {9});
+
+    const auto [documents, profile] = server.FindTopDocumentsWithProfile("cat soigne -collar"s);
+    const auto expected = server.FindTopDocuments("cat soigne -collar"s);
+    ASSERT_EQUAL(documents.size(), 2u);
+    ASSERT_EQUAL(expected.size(), 2u);
+    ASSERT_EQUAL(documents[0].id, expected[0].id);
+    ASSERT_EQUAL(documents[1].id, expected[1].id);
+    ASSERT_EQUAL(profile.plus_terms.size(), 2u);
+    ASSERT_EQUAL(profile.plus_terms[0].term, "cat"s);
+    ASSERT_EQUAL(profile.plus_terms[0].posting_count, 3u);
+    ASSERT(std::abs(profile.plus_terms[0].inverse_document_freq - log(4.0 / 3)) < EPS);
+    ASSERT_EQUAL(profile.minus_terms.size(), 1u);
+    // постинги BANNED-документа не читаются при поиске ACTUAL
+    ASSERT_EQUAL(profile.postings_visited, 4u);
+    ASSERT_EQUAL(profile.predicate_rejects, 0u);
+    ASSERT_EQUAL(profile.documents_scored, 3u);
+    ASSERT_EQUAL(profile.minus_exclusions, 1u);
+    ASSERT(profile.Get(MetricPhase::SCORING).count() > 0);
+
+    const auto rating_profile = server.FindTopDocumentsWithProfile("cat soigne"s, [](int, DocumentStatus, int rating) {
+        return rating > 2;
+    }).profile;
+    ASSERT_EQUAL(rating_profile.postings_visited, 5u);
+    ASSERT_EQUAL(rating_profile.predicate_rejects, 2u);
+}
+
+void TestDocumentFilters() {
+    SearchServer server(""s);
+    server.AddDocument(0, "cat"s, DocumentStatus::ACTUAL, {0});
+    server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {5});
+    server.AddDocument(2, "cat"s, DocumentStatus::BANNED, {10});
+    server.AddDocument(7, "cat dog"s, DocumentStatus::ACTUAL, {7});
+
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, StatusFilter{DocumentStatus::BANNED}).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "cat"s, StatusFilter{DocumentStatus::ACTUAL}).size(), 3u);
+    {
+        const auto documents = server.FindTopDocuments("cat"s, RatingRangeFilter{5, 7});
+        ASSERT_EQUAL(documents.size(), 2u);
+        ASSERT_EQUAL(documents[0].rating, 7);
+    }
+    {
+        const auto documents = server.FindTopDocuments("cat"s, IdSetFilter({2, 7, 100}));
+        ASSERT_EQUAL(documents.size(), 2u);
+        ASSERT_EQUAL(documents[0].id, 2);
+    }
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "cat"s, IdSetFilter({0})).size(), 1u);
+    {
+        // большие id не раздувают фильтр и не переполняют его размер
+        server.AddDocument(numeric_limits<int>::max(), "cat"s, DocumentStatus::ACTUAL, {1});
+        server.AddDocument(2000000000, "cat"s, DocumentStatus::ACTUAL, {1});
+        const IdSetFilter filter({numeric_limits<int>::max(), 7, -3, 7, 2000000000});
+        ASSERT(filter.Contains(numeric_limits<int>::max()) && filter.Contains(7) && filter.Contains(-3));
+        ASSERT(!filter.Contains(0) && !filter.Contains(2000000001));
+        ASSERT_EQUAL(server.FindTopDocuments("cat"s, filter).size(), 3u);
+        server.RemoveDocument(numeric_limits<int>::max());
+        server.RemoveDocument(2000000000);
+    }
+    ASSERT_EQUAL(server.FindTopDocumentsUntil(QueryDeadline{}, "cat"s, RatingRangeFilter{1, 100}).documents.size(), 3u);
+}
+
+void TestSetDocumentStatus() {
+    SearchServer server(""s);
+    server.AddDocument(0, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(2, "soigne dog"s, DocumentStatus::ACTUAL, {3});
+
+    server.SetDocumentStatus(1, DocumentStatus::BANNED);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "cat"s, DocumentStatus::BANNED).size(), 1u);
+    {
+        // IDF считается по всем разделам
+        const auto documents = server.FindTopDocuments("cat"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT(std::abs(documents[0].relevance - 0.5 * log(3.0 / 2)) < EPS);
+    }
+    {
+        const auto [words, status] = server.MatchDocument("fluffy -dog"s, 1);
+        ASSERT_EQUAL(words.size(), 1u);
+        ASSERT_EQUAL(status, DocumentStatus::BANNED);
+    }
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, [](int, DocumentStatus, int) { return true; }).size(), 2u);
+
+    server.SetDocumentStatus(1, DocumentStatus::ACTUAL);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 2u);
+    server.RemoveDocument(1);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+}
+
+void TestImpactIndex() {
+    WorkloadConfig config;
+    config.dictionary_size = 300;
+    config.document_count = 500;
+    config.query_count = 100;
+    const Workload workload = GenerateWorkload(config, 11);
+
+    SearchServer server(workload.GetStopWordsText());
+    for (size_t id = 0; id < workload.documents.size(); ++id) {
+        const DocumentStatus status = id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(static_cast<int>(id), workload.documents[id], status, {static_cast<int>(id % 7)});
+    }
+    server.RemoveDocument(3);
+
+    vector<vector<Document>> expected;
+    for (const string &query : workload.queries) {
+        expected.push_back(server.FindTopDocuments(query));
+    }
+    server.BuildImpactIndex();
+    ASSERT(server.HasImpactIndex());
+    // при равных релевантности и рейтинге порядок документов не определён, сравниваем только их
+    for (size_t i = 0; i < workload.queries.size(); ++i) {
+        const auto documents = server.FindTopDocuments(workload.queries[i]);
+        ASSERT_EQUAL(documents.size(), expected[i].size());
+        for (size_t j = 0; j < documents.size(); ++j) {
+            ASSERT(std::abs(documents[j].relevance - expected[i][j].relevance) < EPS);
+            ASSERT_EQUAL(documents[j].rating, expected[i][j].rating);
+        }
+    }
+    ASSERT_EQUAL(server.FindTopDocuments(workload.queries[0], DocumentStatus::BANNED).size(),
+                 server.FindTopDocuments(execution::par, workload.queries[0], DocumentStatus::BANNED).size());
+
+    server.AddDocument(1000, workload.documents[0], DocumentStatus::ACTUAL, {1});
+    ASSERT(!server.HasImpactIndex());
+}
+
+void TestBooleanQuery() {
+    SearchServer server("in the"s);
+    server.AddDocument(0, "white cat and fancy collar"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(2, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(3, "cat in the white hat"s, DocumentStatus::ACTUAL, {4});
+    server.AddDocument(4, "white dog fancy hat"s, DocumentStatus::BANNED, {5});
+
+    const auto ids = [](const vector<Document> &documents) {
+        set<int> result;
+        for (const Document &document : documents) {
+            result.insert(document.id);
+        }
+        return result;
+    };
+
+    // старый синтаксис не изменился
+    ASSERT(ids(server.FindTopDocuments("cat -collar"s)) == (set<int>{1, 3}));
+    ASSERT(ids(server.FindTopDocuments("+white +cat"s)) == (set<int>{0, 3}));
+    ASSERT(ids(server.FindTopDocuments("+white cat"s)) == (set<int>{0, 3}));
+    ASSERT(ids(server.FindTopDocuments("+white cat"s, DocumentStatus::BANNED)) == (set<int>{4}));
+    ASSERT(ids(server.FindTopDocuments("\"white cat\""s)) == (set<int>{0}));
+    // стоп-слова выброшены и из документа, и из фразы
+    ASSERT(ids(server.FindTopDocuments("\"cat in the white\""s)) == (set<int>{3}));
+    ASSERT(ids(server.FindTopDocuments("cat -\"white cat\""s)) == (set<int>{1, 3}));
+    ASSERT(ids(server.FindTopDocuments("+(collar tail) cat"s)) == (set<int>{0, 1}));
+    ASSERT(ids(server.FindTopDocuments("cat -(collar tail)"s)) == (set<int>{3}));
+    ASSERT(ids(server.FindTopDocuments(execution::par, "+cat -\"white hat\""s)) == (set<int>{0, 1}));
+    ASSERT(server.FindTopDocuments("+cat +parrot"s).empty());
+
+    {
+        // обязательность не меняет релевантность
+        const auto plain = server.FindTopDocuments("white cat"s);
+        const auto required = server.FindTopDocuments("+white +cat"s);
+        ASSERT_EQUAL(required.size(), 2u);
+        for (const Document &document : required) {
+            const auto it = find_if(plain.begin(), plain.end(), [&](const Document &other) { return other.id == document.id; });
+            ASSERT(it != plain.end());
+            ASSERT(std::abs(it->relevance - document.relevance) < EPS);
         }
+    }
+    {
+        const auto [words, status] = server.MatchDocument("+collar cat"s, 1);
+        ASSERT(words.empty());
+    }
+    {
+        const auto [words, status] = server.MatchDocument(execution::par, "\"white cat\" fancy"s, 0);
+        ASSERT_EQUAL(words.size(), 3u);
+    }
 
+    // незакрытые кавычка и скобка остаются частью слова, как до появления операторов
+    server.AddDocument(5, "\"quoted (open"s, DocumentStatus::ACTUAL, {6});
+    ASSERT(ids(server.FindTopDocuments("\"quoted"s)) == (set<int>{5}));
+    ASSERT(ids(server.FindTopDocuments("\"quoted fluffy"s)) == (set<int>{1, 5}));
+    ASSERT(ids(server.FindTopDocuments("(open"s)) == (set<int>{5}));
+    ASSERT(ids(server.FindTopDocuments("+(open"s)) == (set<int>{5}));
+    ASSERT(server.FindTopDocuments("cat -\"quoted"s).size() == 3u);
+    ASSERT(server.FindTopDocuments("cat -(open"s).size() == 3u);
+    // а вот "+слово" теперь оператор: слово обязательно, "+" в него не входит
+    server.AddDocument(6, "+plus"s, DocumentStatus::ACTUAL, {7});
+    ASSERT(server.FindTopDocuments("+plus"s).empty());
+
+    for (const string &query : {"+"s, "++cat"s, "\"white -cat\""s}) {
+        try {
+            server.FindTopDocuments(query);
+            ASSERT_HINT(false, "invalid query must throw"s);
+        } catch (const invalid_argument &) {
+        }
     }
-    for (int document_id: documents_to_remove) {
-        cout << "Found duplicate document id " << document_id << endl;
-        search_server.RemoveDocument(document_id);
+
+    {
+        // наибольший id - обычный документ, а не конец списка постингов
+        SearchServer edge(""s);
+        edge.AddDocument(numeric_limits<int>::max(), "cat dog"s, DocumentStatus::ACTUAL, {1});
+        edge.AddDocument(5, "cat dog"s, DocumentStatus::ACTUAL, {2});
+        const set<int> both = {5, numeric_limits<int>::max()};
+        ASSERT(ids(edge.FindTopDocuments("cat"s)) == both);
+        ASSERT(ids(edge.FindTopDocuments("+cat"s)) == both);
+        ASSERT(ids(edge.FindTopDocuments("+cat +dog"s)) == both);
+        ASSERT(ids(edge.FindTopDocuments("\"cat dog\""s)) == both);
+        ASSERT(ids(edge.FindTopDocuments("+(cat bird)"s)) == both);
     }
 }
 
-void AddDocument(SearchServer &search_server, int document_id, const string &document, DocumentStatus status,
-                 const vector<int> &ratings) {
-    search_server.AddDocument(document_id, document, status, ratings);
+void TestPrefixQuery() {
+    SearchServer server("and"s);
+    server.AddDocument(0, "cat and catalog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "cats everywhere"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(2, "dog catcher"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(3, "cat dog"s, DocumentStatus::ACTUAL, {4});
+    server.AddDocument(4, "parrot"s, DocumentStatus::ACTUAL, {5});
+
+    ASSERT_EQUAL(server.FindTopDocuments("cat*"s).size(), 4u);
+    ASSERT_EQUAL(server.FindTopDocuments("parrot -cat*"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("+cat* dog"s).size(), 4u);
+    ASSERT_EQUAL(server.FindTopDocuments("+cat* +dog"s).size(), 2u);
+    ASSERT(server.FindTopDocuments("+bird* parrot"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "catc*"s).size(), 1u);
+    {
+        const auto [words, status] = server.MatchDocument("cat*"s, 0);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT_EQUAL(words[0], "cat"s);
+        ASSERT_EQUAL(words[1], "catalog"s);
+    }
 
+    TermExpansionOptions options;
+    options.max_prefix_expansions = 1;
+    server.SetTermExpansionOptions(options);
+    // остаётся самое частое слово - cat
+    ASSERT_EQUAL(server.FindTopDocuments("cat*"s).size(), 2u);
+    // исключение не ограничено
+    ASSERT(server.FindTopDocuments("dog -cat*"s).empty());
 }
-// --------- Окончание модульных тестов поисковой системы -----------
 
+void TestFuzzyQuery() {
+    SearchServer server(""s);
+    server.AddDocument(0, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "fluffy dog"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(2, "fluffy cat"s, DocumentStatus::ACTUAL, {3});
+    server.AddDocument(3, "whale"s, DocumentStatus::ACTUAL, {4});
 
-// ----------Добавляем параллельность-------------
+    ASSERT(server.FindTopDocuments("whte"s).empty());
 
+    TermExpansionOptions options;
+    options.max_edit_distance = 1;
+    server.SetTermExpansionOptions(options);
+    {
+        const auto documents = server.FindTopDocuments("whte"s);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT_EQUAL(documents[0].id, 0);
+        ASSERT(std::abs(documents[0].relevance - 0.5 * 0.5 * log(4.0)) < EPS);
+    }
+    // слово из словаря не раскрывается
+    ASSERT_EQUAL(server.FindTopDocuments("whale"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("flufy"s).size(), 2u);
+    ASSERT(server.FindTopDocuments("fluffy -doog"s).size() == 2u);
+    ASSERT(server.FindTopDocuments("+whte"s).empty());
+    ASSERT(server.FindTopDocuments("wht"s).empty());
+
+    options.max_edit_distance = 2;
+    server.SetTermExpansionOptions(options);
+    ASSERT_EQUAL(server.FindTopDocuments("whle"s).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments(execution::par, "fulffy"s).size(), 2u);
+    {
+        // расстояние 1 весит больше, чем 2
+        const auto documents = server.FindTopDocuments("whle"s);
+        ASSERT_EQUAL(documents[0].id, 3);
+    }
+    server.BuildImpactIndex();
+    ASSERT_EQUAL(server.FindTopDocuments("whle"s)[0].id, 3);
+}
 
+void TestRankingModels() {
+    SearchServer server(""s);
+    server.AddDocument(0, "white cat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(2, "dog"s, DocumentStatus::ACTUAL, {3});
 
+    const double tf_idf = server.FindTopDocuments("fluffy"s)[0].relevance;
+    ASSERT(std::abs(tf_idf - 0.5 * log(3.0)) < EPS);
 
+    RankingOptions options;
+    options.model = RankingModel::BM25;
+    server.SetRankingOptions(options);
+    {
+        const double idf = log(1.0 + 2.5 / 1.5);
+        const double expected = idf * 2.0 * 2.2 / (2.0 + 1.2 * (0.25 + 0.75 * 4.0 / (7.0 / 3.0)));
+        const auto documents = server.FindTopDocuments("fluffy"s);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT(std::abs(documents[0].relevance - expected) < EPS);
+    }
+    {
+        // все пути оценки дают одинаковую релевантность
+        const auto seq = server.FindTopDocuments("cat white"s);
+        const auto par = server.FindTopDocuments(execution::par, "cat white"s);
+        const auto required = server.FindTopDocuments("+cat white"s);
+        ASSERT_EQUAL(seq.size(), 2u);
+        ASSERT_EQUAL(par.size(), 2u);
+        ASSERT_EQUAL(required.size(), 2u);
+        for (size_t i = 0; i < seq.size(); ++i) {
+            ASSERT_EQUAL(seq[i].id, par[i].id);
+            ASSERT_EQUAL(seq[i].id, required[i].id);
+            ASSERT(std::abs(seq[i].relevance - par[i].relevance) < EPS);
+            ASSERT(std::abs(seq[i].relevance - required[i].relevance) < EPS);
+        }
+        // у короткого документа вклад слова cat больше
+        ASSERT_EQUAL(seq[0].id, 0);
+    }
 
-string GenerateWord(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution('a', 'z')(generator));
+    const TermScorer scorer(options, 1.5, 3.0);
+    const vector<double> term_freqs = {0.5, 0.25, 1.0, 0.1, 0.3, 0.2, 0.75};
+    const vector<double> lengths = {2.0, 4.0, 1.0, 10.0, 3.0, 5.0, 4.0};
+    vector<double> scores(term_freqs.size());
+    scorer.ScoreBlock(term_freqs.data(), lengths.data(), scores.data(), scores.size());
+    for (size_t i = 0; i < scores.size(); ++i) {
+        ASSERT(std::abs(scores[i] - scorer.Score(term_freqs[i], lengths[i])) < 1e-12);
     }
-    return word;
 }
-vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWord(generator, max_length));
+
+void TestShardedSearchServer() {
+    WorkloadConfig config;
+    config.dictionary_size = 300;
+    config.document_count = 400;
+    config.query_count = 100;
+    const Workload workload = GenerateWorkload(config, 5);
+
+    SearchServer server(workload.GetStopWordsText());
+    ShardingOptions options;
+    options.shard_count = 3;
+    options.pin_to_numa_nodes = true;
+    ShardedSearchServer sharded(workload.GetStopWordsText(), options);
+    for (size_t id = 0; id < workload.documents.size(); ++id) {
+        const DocumentStatus status = id % 7 == 0 ? DocumentStatus::IRRELEVANT : DocumentStatus::ACTUAL;
+        const vector<int> ratings = {static_cast<int>(id % 11)};
+        server.AddDocument(static_cast<int>(id), workload.documents[id], status, ratings);
+        sharded.AddDocument(static_cast<int>(id), workload.documents[id], status, ratings);
+    }
+    vector<int> removed_ids;
+    for (int id = 0; id < 400; id += 9) {
+        server.RemoveDocument(id);
+        removed_ids.push_back(id);
+    }
+    removed_ids.push_back(9);
+    sharded.RemoveDocument(0);
+    sharded.RemoveDocuments(removed_ids);
+    ASSERT_EQUAL(sharded.GetDocumentCount(), server.GetDocumentCount());
+    for (size_t shard = 0; shard < sharded.GetShardCount(); ++shard) {
+        ASSERT(sharded.GetShard(shard).GetDocumentCount() > 0);
+    }
+
+    const auto assert_same = [](const vector<Document> &lhs, const vector<Document> &rhs) {
+        ASSERT_EQUAL(lhs.size(), rhs.size());
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            ASSERT(std::abs(lhs[i].relevance - rhs[i].relevance) < EPS);
+            ASSERT_EQUAL(lhs[i].rating, rhs[i].rating);
+        }
+    };
+    for (const string &query : workload.queries) {
+        assert_same(sharded.FindTopDocuments(query), server.FindTopDocuments(query));
     }
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
+    assert_same(sharded.FindTopDocuments(workload.queries[0], DocumentStatus::IRRELEVANT),
+                server.FindTopDocuments(workload.queries[0], DocumentStatus::IRRELEVANT));
+    const auto even = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+    assert_same(sharded.FindTopDocuments(workload.queries[1], even), server.FindTopDocuments(workload.queries[1], even));
+
+    RankingOptions ranking;
+    ranking.model = RankingModel::BM25;
+    server.SetRankingOptions(ranking);
+    sharded.SetRankingOptions(ranking);
+    assert_same(sharded.FindTopDocuments(workload.queries[2]), server.FindTopDocuments(workload.queries[2]));
+
+    {
+        const auto [words, status] = sharded.MatchDocument(workload.documents[10], 10);
+        ASSERT_EQUAL(words.size(), get<0>(server.MatchDocument(workload.documents[10], 10)).size());
+    }
+    {
+        // префиксы и опечатки раскрываются по общему словарю: шард без самого частого слова
+        // префикса или без точного слова запроса раскрывает так же, как один сервер
+        SearchServer single("and"s);
+        ShardedSearchServer split("and"s, ShardingOptions{2, false});
+        vector<vector<int>> ids_by_shard(2);
+        for (int id = 0; ids_by_shard[0].size() < 3 || ids_by_shard[1].size() < 2; ++id) {
+            ids_by_shard[split.GetShardIndex(id)].push_back(id);
+        }
+        const vector<pair<int, string>> documents = {
+                {ids_by_shard[0][0], "cab dogz"s}, {ids_by_shard[0][1], "cab"s}, {ids_by_shard[0][2], "cab"s},
+                {ids_by_shard[1][0], "cat dog"s}, {ids_by_shard[1][1], "cat"s}};
+        for (const auto &[id, text] : documents) {
+            single.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+            split.AddDocument(id, text, DocumentStatus::ACTUAL, {1});
+        }
+        TermExpansionOptions expansion;
+        expansion.max_prefix_expansions = 1;
+        expansion.max_edit_distance = 1;
+        single.SetTermExpansionOptions(expansion);
+        split.SetTermExpansionOptions(expansion);
+        const auto ids = [](const vector<Document> &found) {
+            set<int> result;
+            for (const Document &document : found) {
+                result.insert(document.id);
+            }
+            return result;
+        };
+        ASSERT(ids(split.FindTopDocuments("ca*"s)) == set<int>(ids_by_shard[0].begin(), ids_by_shard[0].begin() + 3));
+        ASSERT(ids(split.FindTopDocuments("ca*"s)) == ids(single.FindTopDocuments("ca*"s)));
+        ASSERT(ids(split.FindTopDocuments("dogz"s)) == set<int>{ids_by_shard[0][0]});
+        ASSERT(ids(split.FindTopDocuments("dogz"s)) == ids(single.FindTopDocuments("dogz"s)));
+        assert_same(split.FindTopDocuments("-cab ca*"s), single.FindTopDocuments("-cab ca*"s));
+    }
+    try {
+        sharded.AddDocument(10, "duplicate"s, DocumentStatus::ACTUAL, {});
+        ASSERT_HINT(false, "duplicate id must throw"s);
+    } catch (const invalid_argument &) {
+    }
+    ASSERT_EQUAL(sharded.GetDocumentCount(), server.GetDocumentCount());
+}
+
+void TestRpcProtocol() {
+    SearchServer server("and"s);
+    {
+        istringstream snapshot("0\t0\t1,2,3\twhite cat and collar\n\n1\t0\t\tfluffy cat\n"s);
+        ASSERT_EQUAL(LoadSnapshot(server, snapshot), 2);
+        istringstream broken("2\t9\t1\tdog\n"s);
+        try {
+            LoadSnapshot(server, broken);
+            ASSERT_HINT(false, "unknown status must throw"s);
+        } catch (const invalid_argument &) {
+        }
+    }
+
+    const uint8_t find = static_cast<uint8_t>(RpcType::FIND_TOP_DOCUMENTS);
+    const uint8_t add = static_cast<uint8_t>(RpcType::ADD_DOCUMENT);
+    const string add_frame = RpcWriter(add, 1).WriteInt32(2).WriteUint8(0).WriteUint32(1).WriteInt32(9)
+                                     .WriteString("cat cat"s).Finish();
+    const string find_frame = RpcWriter(find, 2).WriteString("cat"s).WriteUint8(0).Finish();
+    const string match_frame = RpcWriter(static_cast<uint8_t>(RpcType::MATCH_DOCUMENT), 3).WriteInt32(0)
+                                       .WriteString("white collar dog"s).Finish();
+    const string bad_frame = RpcWriter(find, 4).WriteString("--cat"s).WriteUint8(0).Finish();
+
+    ASSERT_EQUAL(GetCompleteFrameSize(string_view(find_frame).substr(0, 6)), 0u);
+    ASSERT_EQUAL(GetCompleteFrameSize(find_frame + add_frame), find_frame.size());
+
+    // поиск после добавления в той же пачке видит новый документ
+    const auto responses = HandleRpcBatch(server, {add_frame, find_frame, match_frame, bad_frame});
+    ASSERT_EQUAL(responses.size(), 4u);
+    {
+        RpcReader reader(responses[0]);
+        ASSERT_EQUAL(reader.GetType(), add | RPC_RESPONSE_FLAG);
+        ASSERT_EQUAL(reader.GetRequestId(), 1u);
+        ASSERT(reader.AtEnd());
+    }
+    {
+        RpcReader reader(responses[1]);
+        ASSERT_EQUAL(reader.GetType(), find | RPC_RESPONSE_FLAG);
+        ASSERT_EQUAL(reader.ReadUint32(), 3u);
+        ASSERT_EQUAL(reader.ReadInt32(), 2);
+        const double relevance = reader.ReadDouble();
+        ASSERT(std::abs(relevance - server.FindTopDocuments("cat"s)[0].relevance) < EPS);
+        ASSERT_EQUAL(reader.ReadInt32(), 9);
+    }
+    {
+        RpcReader reader(responses[2]);
+        ASSERT_EQUAL(reader.ReadUint8(), static_cast<uint8_t>(DocumentStatus::ACTUAL));
+        ASSERT_EQUAL(reader.ReadUint32(), 2u);
+        ASSERT_EQUAL(reader.ReadString(), "collar"sv);
+        ASSERT_EQUAL(reader.ReadString(), "white"sv);
+    }
+    {
+        RpcReader reader(responses[3]);
+        ASSERT_EQUAL(reader.GetType(), static_cast<uint8_t>(RpcType::ERROR) | RPC_RESPONSE_FLAG);
+        ASSERT_EQUAL(reader.GetRequestId(), 4u);
+        ASSERT(!reader.ReadString().empty());
+    }
+    {
+        // обрезанный кадр - ответ с ошибкой, а не исключение
+        RpcReader reader(HandleRpcRequest(server, string_view(find_frame).substr(0, find_frame.size() - 1)));
+        ASSERT_EQUAL(reader.GetType(), static_cast<uint8_t>(RpcType::ERROR) | RPC_RESPONSE_FLAG);
+    }
+    {
+        // id сверх ограничения отклоняется до AddDocument, сервер не меняется
+        RpcLimits limits;
+        limits.max_document_id = 1000;
+        const int document_count = server.GetDocumentCount();
+        for (const int document_id : {1001, 2000000000, -1}) {
+            const string frame = RpcWriter(add, 5).WriteInt32(document_id).WriteUint8(0).WriteUint32(0)
+                                         .WriteString("dog"s).Finish();
+            RpcReader reader(HandleRpcRequest(server, frame, limits));
+            ASSERT_EQUAL(reader.GetType(), static_cast<uint8_t>(RpcType::ERROR) | RPC_RESPONSE_FLAG);
+        }
+        ASSERT_EQUAL(server.GetDocumentCount(), document_count);
+        const string frame = RpcWriter(add, 6).WriteInt32(1000).WriteUint8(0).WriteUint32(0)
+                                     .WriteString("dog"s).Finish();
+        RpcReader reader(HandleRpcBatch(server, {frame}, limits)[0]);
+        ASSERT_EQUAL(reader.GetType(), add | RPC_RESPONSE_FLAG);
+        ASSERT_EQUAL(server.GetDocumentCount(), document_count + 1);
+    }
+}
+
+#ifdef __linux__
+void TestRpcServerBackpressure() {
+    SearchServer server("and"s);
+    for (int id = 0; id < 10; ++id) {
+        server.AddDocument(id, "cat number "s + to_string(id), DocumentStatus::ACTUAL, {id});
+    }
+    RpcServerOptions options;
+    options.unix_socket_path = (filesystem::temp_directory_path() / "search_server_backpressure_test.sock").string();
+    options.limits.max_pending_output_bytes = 64u << 10;
+    options.limits.resume_output_bytes = 16u << 10;
+    RpcServer rpc_server(server, options);
+    thread loop([&rpc_server]() { rpc_server.Run(); });
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, options.unix_socket_path.c_str());
+    ASSERT(connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0);
+
+    // клиент шлёт запросы и не читает ответы: сервер перестаёт читать, и буферы сокета
+    // заполняются, а не буфер ответов в памяти сервера
+    const string frame = RpcWriter(static_cast<uint8_t>(RpcType::FIND_TOP_DOCUMENTS), 1)
+                                 .WriteString("cat"s).WriteUint8(0).Finish();
+    string frames;
+    for (int i = 0; i < 1000; ++i) {
+        frames += frame;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    const size_t max_sent = 256u << 20;
+    size_t sent = 0;
+    int idle_rounds = 0;
+    while (sent < max_sent && idle_rounds < 20) {
+        const ssize_t size = send(fd, frames.data() + sent % frames.size(), frames.size() - sent % frames.size(),
+                                  MSG_NOSIGNAL);
+        if (size > 0) {
+            sent += static_cast<size_t>(size);
+            idle_rounds = 0;
+        } else {
+            ASSERT(errno == EAGAIN || errno == EWOULDBLOCK);
+            ++idle_rounds;
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+    }
+    ASSERT_HINT(sent < max_sent, "server must stop reading a client that does not read replies"s);
+
+    // клиент забирает ответы: сервер возобновляет чтение и отвечает на каждый запрос
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+    const size_t expected = sent / frame.size();
+    size_t received = 0;
+    string input;
+    char buffer[64 * 1024];
+    while (received < expected) {
+        const ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        ASSERT(size > 0);
+        input.append(buffer, static_cast<size_t>(size));
+        string_view rest = input;
+        size_t frame_size;
+        while ((frame_size = GetCompleteFrameSize(rest)) > 0) {
+            ASSERT_EQUAL(RpcReader(rest.substr(0, frame_size)).ReadUint32(), 5u);
+            rest.remove_prefix(frame_size);
+            ++received;
+        }
+        input.erase(0, input.size() - rest.size());
+    }
+    ASSERT_EQUAL(received, expected);
+
+    close(fd);
+    rpc_server.Stop();
+    loop.join();
+}
+#endif
+
+void TestIngest() {
+    const string tsv_path = (filesystem::temp_directory_path() / "search_server_ingest_test.tsv").string();
+    const string json_path = (filesystem::temp_directory_path() / "search_server_ingest_test.jsonl").string();
+    {
+        ofstream tsv(tsv_path);
+        for (int id = 0; id < 50; ++id) {
+            tsv << id << "\t0\t" << id << ",1\tword" << id % 5 << " common text\n";
+        }
+        tsv << "broken line\n";
+        tsv << "3\t0\t1\tduplicate id\r\n";
+        ofstream json(json_path);
+        json << R"({"id": 100, "status": 1, "ratings": [4, -2], "text": "quoted \"cat\" caf\u00e9"})" << "\n";
+        json << R"({"text": "ratings are optional", "id": 101})" << "\n";
+        json << R"({"id": 102})" << "\n";
+    }
+
+    SearchServer server("text"s);
+    IngestOptions options;
+    options.parse_threads = 3;
+    options.batch_size = 4;
+    options.max_batches_in_flight = 2;
+    const IngestStats tsv_stats = IngestFile(server, tsv_path, options);
+    ASSERT_EQUAL(tsv_stats.documents, 50u);
+    ASSERT_EQUAL(tsv_stats.rejected, 2u);
+    ASSERT(!tsv_stats.first_error.empty());
+    ASSERT_EQUAL(server.GetDocumentCount(), 50);
+    ASSERT_EQUAL(server.FindTopDocuments("word3"s).size(), 5u);
+    {
+        // после ingest сервер ведёт себя так же, как после AddDocument
+        SearchServer reference("text"s);
+        for (int id = 0; id < 50; ++id) {
+            reference.AddDocument(id, "word"s + to_string(id % 5) + " common text"s, DocumentStatus::ACTUAL, {id, 1});
+        }
+        const auto documents = server.FindTopDocuments("word3 common"s);
+        const auto expected = reference.FindTopDocuments("word3 common"s);
+        ASSERT_EQUAL(documents.size(), expected.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL(documents[i].id, expected[i].id);
+            ASSERT(std::abs(documents[i].relevance - expected[i].relevance) < EPS);
+        }
+    }
+
+    const IngestStats json_stats = IngestFile(server, json_path);
+    ASSERT_EQUAL(json_stats.documents, 2u);
+    ASSERT_EQUAL(json_stats.rejected, 1u);
+    {
+        const auto [words, status] = server.MatchDocument("quoted café"s, 100);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT_EQUAL(status, DocumentStatus::IRRELEVANT);
+    }
+    ASSERT_EQUAL(server.FindTopDocuments("optional"s).size(), 1u);
+    {
+        // нулевой предел очереди не должен останавливать загрузку
+        SearchServer other("text"s);
+        IngestOptions unbounded;
+        unbounded.max_batches_in_flight = 0;
+        ASSERT_EQUAL(IngestFile(other, tsv_path, unbounded).documents, 50u);
+    }
+    {
+        // \b и \f - разделители, суррогатная пара - один символ в UTF-8, одиночный суррогат - ошибка
+        const SnapshotRecord record = ParseJsonSnapshotLine(R"({"id": 1, "text": "a\bb\fc \uD83D\uDE00 \u00e9"})");
+        ASSERT_EQUAL(record.text, "a b c \xF0\x9F\x98\x80 \xC3\xA9"s);
+        for (const string_view line : {R"({"id": 1, "text": "\uD83D"})"sv, R"({"id": 1, "text": "\uDE00"})"sv,
+                                       R"({"id": 1, "text": "\uD83D\u0041"})"sv}) {
+            try {
+                ParseJsonSnapshotLine(line);
+                ASSERT_HINT(false, "unpaired surrogate must throw"s);
+            } catch (const invalid_argument &) {
+            }
+        }
+    }
+
+    filesystem::remove(tsv_path);
+    filesystem::remove(json_path);
+}
+
+void TestScoreAccumulator() {
+    ScoreAccumulator accumulator;
+    accumulator.Reset(10);
+    accumulator.Add(7, 1.0);
+    accumulator.Add(2, 0.5);
+    accumulator.Add(7, 0.25);
+    ASSERT_EQUAL(accumulator.GetSize(), 2u);
+    ASSERT(accumulator.Erase(2));
+    ASSERT(!accumulator.Erase(2));
+    ASSERT(!accumulator.Erase(100));
+    accumulator.Add(2, 3.0);
+    vector<pair<int, double>> scores;
+    accumulator.ForEach([&scores](int id, double score) { scores.emplace_back(id, score); });
+    ASSERT(scores == (vector<pair<int, double>>{{2, 3.0}, {7, 1.25}}));
+
+    // после сброса прежние суммы не видны, а границу можно увеличить
+    accumulator.Reset(20);
+    ASSERT_EQUAL(accumulator.GetSize(), 0u);
+    accumulator.Add(15, 1.0);
+    accumulator.Add(7, 2.0);
+    scores.clear();
+    accumulator.ForEach([&scores](int id, double score) { scores.emplace_back(id, score); });
+    ASSERT(scores == (vector<pair<int, double>>{{7, 2.0}, {15, 1.0}}));
+
+    // после запроса к большому серверу память возвращается, когда слотов нужно намного меньше
+    accumulator.Reset(100000);
+    accumulator.Add(99999, 1.0);
+    accumulator.Reset(30000);
+    ASSERT_EQUAL(accumulator.GetCapacity(), 100000u);
+    accumulator.Reset(20);
+    ASSERT_EQUAL(accumulator.GetCapacity(), 20u);
+    ASSERT(!accumulator.Erase(15));
+    accumulator.Add(15, 1.0);
+    ASSERT_EQUAL(accumulator.GetSize(), 1u);
+}
+
+void TestMemoryStats() {
+    SearchServer server("and"s);
+    ASSERT_EQUAL(server.GetMemoryStats().postings.live_bytes, 0u);
+    for (int id = 0; id < 500; ++id) {
+        server.AddDocument(id, "common word"s + to_string(id % 7) + " and text"s, DocumentStatus::ACTUAL, {1});
+    }
+    const IndexMemoryStats filled = server.GetMemoryStats();
+    ASSERT(filled.postings.live_bytes > 0);
+    ASSERT(filled.forward_index.live_bytes > 0);
+    ASSERT(filled.postings.reserved_bytes >= filled.postings.live_bytes);
+    ASSERT(filled.postings.allocation_count >= 500u);
+
+    // запрос по упорядоченным постингам запоминает встреченные документы в арене; 500 документов
+    // не помещаются во встроенный буфер, после запроса арена всё вернула
+    server.BuildImpactIndex();
+    ASSERT_EQUAL(server.FindTopDocuments("common"s).size(), 5u);
+    const IndexMemoryStats queried = server.GetMemoryStats();
+    ASSERT(queried.query_arenas.allocation_count > 0);
+    ASSERT_EQUAL(queried.query_arenas.live_bytes, 0u);
+    ASSERT(queried.query_arenas.peak_live_bytes > 0);
+
+    for (int id = 0; id < 500; ++id) {
+        server.RemoveDocument(id);
+    }
+    const IndexMemoryStats removed = server.GetMemoryStats();
+    // пустые списки постингов слов остаются
+    ASSERT(removed.postings.live_bytes < filled.postings.live_bytes);
+    ASSERT_EQUAL(removed.forward_index.live_bytes, 0u);
+    ASSERT_EQUAL(removed.postings.peak_live_bytes, filled.postings.live_bytes);
+
+    // перемещённый сервер продолжает пользоваться теми же пулами
+    server.AddDocument(1, "moved text"s, DocumentStatus::ACTUAL, {1});
+    SearchServer moved(std::move(server));
+    moved.AddDocument(2, "moved again"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(moved.FindTopDocuments("moved"s).size(), 2u);
+    ASSERT(moved.GetMemoryStats().forward_index.live_bytes > 0);
+}
+
+void TestStopWords() {
+    {
+        vector<string> words;
+        for (int i = 0; i < 1000; ++i) {
+            words.push_back("w"s + to_string(i));
+        }
+        words.push_back("w7"s);
+        words.push_back(""s);
+        const StopWordSet stop_words(words);
+        ASSERT_EQUAL(stop_words.GetSize(), 1000u);
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT(stop_words.Contains("w"s + to_string(i)));
+            ASSERT(!stop_words.Contains("x"s + to_string(i)));
+        }
+        ASSERT(!stop_words.Contains(""s));
+        ASSERT(!StopWordSet().Contains("w1"s));
+    }
+
+    SearchServer server("and with"s);
+    server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "and and and"s, DocumentStatus::ACTUAL, {3});
+    ASSERT(server.FindTopDocuments("and"s).empty());
+    ASSERT_EQUAL(server.GetDocumentLength(1), 4);
+    // стоп-слова документа не разрывают фразу
+    ASSERT_EQUAL(server.FindTopDocuments("\"pet nasty\""s).size(), 1u);
+    const double rat_relevance = server.FindTopDocuments("rat"s)[0].relevance;
+
+    const auto volumes = server.GetStopWordVolumes();
+    ASSERT_EQUAL(volumes.size(), 2u);
+    ASSERT_EQUAL(volumes[0].word, "and"s);
+    ASSERT_EQUAL(volumes[0].document_count, 2u);
+    ASSERT_EQUAL(volumes[1].document_count, 1u);
+    const auto heaviest = server.GetHeaviestTerms(2);
+    ASSERT_EQUAL(heaviest.size(), 2u);
+    ASSERT_EQUAL(heaviest[0].word, "funny"s);
+    ASSERT_EQUAL(heaviest[0].document_count, 2u);
+    ASSERT(!heaviest[0].is_stop_word);
+
+    // смена стоп-слов без переиндексации: "and" снова ищется, "pet" пропадает из запросов
+    server.SetStopWords("with pet"s);
+    ASSERT(server.IsStopWord("pet"s));
+    ASSERT_EQUAL(server.FindTopDocuments("and"s).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments("and"s)[0].id, 3);
+    ASSERT(server.FindTopDocuments("pet"s).empty());
+    ASSERT(server.FindTopDocuments("pe*"s).empty());
+    ASSERT(std::abs(server.FindTopDocuments("rat"s)[0].relevance - rat_relevance) < EPS);
+    ASSERT_EQUAL(get<0>(server.MatchDocument("and rat pet"s, 1)).size(), 2u);
 }
-string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
+
+void TestAnalyzer() {
+    {
+        AnalyzerOptions options;
+        options.fold_case = true;
+        options.split_punctuation = true;
+        const Analyzer analyzer(options);
+        ASSERT_EQUAL(analyzer.NormalizeText("Cat, cat. CAT!"s), "cat  cat  cat "s);
+        ASSERT_EQUAL(analyzer.NormalizeText("Ёжик «В Тумане» ÉTÉ"s), "ёжик  в тумане  été"s);
+        // операторы запроса остаются, дефис внутри слова - разделитель
+        ASSERT_EQUAL(analyzer.NormalizeQuery("+Cat -Dog \"White Cat\" -(A B) Pre* e-mail"s),
+                     "+cat -dog \"white cat\" -(a b) pre* e mail"s);
+        // без split_punctuation меняется только регистр
+        options.split_punctuation = false;
+        ASSERT_EQUAL(Analyzer(options).NormalizeText("Cat, Ёж"s), "cat, ёж"s);
+        // некорректный UTF-8 проходит как есть
+        ASSERT_EQUAL(Analyzer(options).NormalizeText("A\xFF\xC3" "B"s), "a\xFF\xC3" "b"s);
+    }
+    {
+        AnalyzerOptions options;
+        options.stem = true;
+        const Analyzer analyzer(options);
+        ASSERT_EQUAL(analyzer.NormalizeText("cats ponies horses glass bus"s), "cat pony horse glass bus"s);
+        ASSERT_EQUAL(analyzer.NormalizeQuery("-cats \"ponies\" cats*"s), "-cat \"pony\" cats*"s);
+    }
+
+    {
+        // стоп-слова каждый раз нормализуются из исходных
+        SearchServer server("The Cats"s);
+        AnalyzerOptions options;
+        options.fold_case = true;
+        options.stem = true;
+        server.SetAnalyzerOptions(options);
+        ASSERT(server.IsStopWord("cat"s));
+        server.SetAnalyzerOptions({});
+        ASSERT(server.IsStopWord("Cats"s) && server.IsStopWord("The"s));
+        ASSERT(!server.IsStopWord("cat"s));
+        options.stem = false;
+        server.SetAnalyzerOptions(options);
+        ASSERT(server.IsStopWord("cats"s) && !server.IsStopWord("cat"s));
+    }
+
+    SearchServer server("The and"s);
+    AnalyzerOptions options;
+    options.fold_case = true;
+    options.split_punctuation = true;
+    options.stem = true;
+    server.SetAnalyzerOptions(options);
+    server.AddDocument(1, "The Cats, and the Dogs."s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "Кошка и собака"s, DocumentStatus::ACTUAL, {2});
+    ASSERT_EQUAL(server.GetDocumentLength(1), 2);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("CATS!"s).size(), 1u);
+    ASSERT_EQUAL(server.FindTopDocuments("КОШКА"s).size(), 1u);
+    ASSERT(server.FindTopDocuments("cat -DOG"s).empty());
+    ASSERT_EQUAL(server.FindTopDocuments("\"Cats, Dogs\""s).size(), 1u);
+    ASSERT(server.FindTopDocuments("THE"s).empty());
+    {
+        const auto [words, status] = server.MatchDocument("Dogs cats"s, 1);
+        ASSERT(words == (vector<string_view>{"cat"sv, "dog"sv}));
+    }
+    try {
+        server.FindTopDocuments("cat\x01"s);
+        ASSERT_HINT(false, "control characters must throw"s);
+    } catch (const invalid_argument &) {
+    }
+    try {
+        server.SetAnalyzerOptions({});
+        ASSERT_HINT(false, "analyzer can't change after documents are added"s);
+    } catch (const logic_error &) {
+    }
+}
+
+void TestIndexStatistics() {
+    SearchServer server("and"s);
+    server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat cat bird"s, DocumentStatus::BANNED, {2});
+    server.AddDocument(3, "cat fish"s, DocumentStatus::ACTUAL, {3});
+
+    IndexStatistics statistics = server.GetIndexStatistics();
+    ASSERT_EQUAL(statistics.document_count, 3);
+    // стоп-слово тоже индексируется: and, bird, cat, dog, fish
+    ASSERT_EQUAL(statistics.term_count, 5u);
+    ASSERT_EQUAL(statistics.dictionary_size, 5u);
+    ASSERT_EQUAL(statistics.posting_count, 7u);
+    ASSERT_EQUAL(statistics.token_count, 8u);
+    // cat в трёх документах - корзина [2, 4), остальные по одному
+    ASSERT_EQUAL(statistics.posting_length_histogram[0], 4u);
+    ASSERT_EQUAL(statistics.posting_length_histogram[1], 1u);
+    ASSERT(statistics.dictionary_bytes > 0 && statistics.posting_bytes > 0 && statistics.forward_index_bytes > 0);
+    ASSERT(statistics.stop_word_bytes > 0 && statistics.column_bytes > 0);
+    ASSERT_EQUAL(statistics.impact_index_bytes, 0u);
+    const size_t text_bytes = statistics.document_text_bytes;
+    ASSERT(text_bytes >= "cat and dogcat cat birdcat fish"s.size());
+
+    server.BuildImpactIndex();
+    ASSERT(server.GetIndexStatistics().impact_index_bytes > 0);
+
+    server.RemoveDocument(2);
+    server.RemoveDocument(execution::par, 3);
+    statistics = server.GetIndexStatistics();
+    ASSERT_EQUAL(statistics.document_count, 1);
+    ASSERT_EQUAL(statistics.term_count, 3u);
+    ASSERT_EQUAL(statistics.dictionary_size, 5u);
+    ASSERT_EQUAL(statistics.posting_count, 3u);
+    ASSERT_EQUAL(statistics.token_count, 3u);
+    ASSERT_EQUAL(statistics.posting_length_histogram[0], 3u);
+    ASSERT_EQUAL(statistics.posting_length_histogram[1], 0u);
+    ASSERT_EQUAL(statistics.document_text_bytes, text_bytes);
+
+    {
+        // колонки растут по числу документов, а не по наибольшему id
+        SearchServer sparse("and"s);
+        sparse.AddDocument(2000000000, "cat and dog"s, DocumentStatus::ACTUAL, {5});
+        sparse.AddDocument(numeric_limits<int>::max(), "cat bird"s, DocumentStatus::BANNED, {7});
+        const size_t column_bytes = sparse.GetIndexStatistics().column_bytes;
+        ASSERT(column_bytes > 0 && column_bytes < 1024);
+        ASSERT_EQUAL(sparse.GetDocumentLength(numeric_limits<int>::max()), 2);
+        for (const auto &found : {sparse.FindTopDocuments("cat"s), sparse.FindTopDocuments(execution::par, "cat"s)}) {
+            ASSERT_EQUAL(found.size(), 1u);
+            ASSERT_EQUAL(found[0].id, 2000000000);
+            ASSERT_EQUAL(found[0].rating, 5);
         }
-        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
-            query.push_back('-');
+        ASSERT_EQUAL(sparse.FindTopDocuments("cat"s, DocumentStatus::BANNED)[0].id, numeric_limits<int>::max());
+
+        // слот удалённого документа достаётся следующему
+        sparse.RemoveDocument(2000000000);
+        sparse.AddDocument(7, "cat fish"s, DocumentStatus::ACTUAL, {1});
+        ASSERT_EQUAL(sparse.GetIndexStatistics().column_bytes, column_bytes);
+        const auto found = sparse.FindTopDocuments("cat -dog"s);
+        ASSERT_EQUAL(found.size(), 1u);
+        ASSERT_EQUAL(found[0].id, 7);
+        ASSERT_EQUAL(found[0].rating, 1);
+        ASSERT_EQUAL(sparse.GetDocumentLength(7), 2);
+    }
+}
+
+void TestRemoveDocuments() {
+    WorkloadConfig config;
+    config.dictionary_size = 300;
+    config.document_count = 600;
+    config.query_count = 100;
+    const Workload workload = GenerateWorkload(config, 17);
+
+    SearchServer one_by_one(workload.GetStopWordsText());
+    SearchServer bulk(workload.GetStopWordsText());
+    for (size_t id = 0; id < workload.documents.size(); ++id) {
+        const DocumentStatus status = id % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        one_by_one.AddDocument(static_cast<int>(id), workload.documents[id], status, {static_cast<int>(id % 5)});
+        bulk.AddDocument(static_cast<int>(id), workload.documents[id], status, {static_cast<int>(id % 5)});
+    }
+    vector<int> removed_ids;
+    for (int id = 0; id < 600; id += 3) {
+        one_by_one.RemoveDocument(id);
+        removed_ids.push_back(id);
+    }
+    // повторы и неизвестные id пропускаются
+    removed_ids.push_back(3);
+    removed_ids.push_back(10000);
+    bulk.RemoveDocuments(removed_ids);
+    bulk.RemoveDocuments({});
+
+    ASSERT_EQUAL(bulk.GetDocumentCount(), 400);
+    ASSERT(bulk.GetWordFrequencies(3).empty());
+    ASSERT(std::find(bulk.begin(), bulk.end(), 3) == bulk.end());
+    const IndexStatistics expected_statistics = one_by_one.GetIndexStatistics();
+    const IndexStatistics statistics = bulk.GetIndexStatistics();
+    ASSERT_EQUAL(statistics.term_count, expected_statistics.term_count);
+    ASSERT_EQUAL(statistics.posting_count, expected_statistics.posting_count);
+    ASSERT_EQUAL(statistics.token_count, expected_statistics.token_count);
+    ASSERT(statistics.posting_length_histogram == expected_statistics.posting_length_histogram);
+    for (const string &query : workload.queries) {
+        const auto expected = one_by_one.FindTopDocuments(query);
+        const auto documents = bulk.FindTopDocuments(query);
+        ASSERT_EQUAL(documents.size(), expected.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT(std::abs(documents[i].relevance - expected[i].relevance) < EPS);
         }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+        ASSERT(bulk.FindTopDocuments(query, DocumentStatus::BANNED).size()
+               == one_by_one.FindTopDocuments(query, DocumentStatus::BANNED).size());
     }
-    return query;
+
+    // освободившийся id можно добавить заново
+    bulk.AddDocument(3, workload.documents[4], DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(bulk.GetDocumentCount(), 401);
 }
-vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+
+void TestQueryBudget() {
+    SearchServer server("and"s);
+    for (int id = 0; id < 300; ++id) {
+        const string text = id == 0 ? "common rare extra"s : id < 3 ? "common and rare"s : "common word"s;
+        server.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+    }
+    {
+        const SearchResult result = server.FindTopDocumentsWithin(QueryBudget{}, "common rare"s);
+        ASSERT(!result.is_partial);
+        ASSERT_EQUAL(result.postings_scored, 303u);
+        const auto expected = server.FindTopDocuments("common rare"s);
+        ASSERT_EQUAL(result.documents.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(result.documents[i].id, expected[i].id);
+        }
+    }
+    {
+        // редкое слово оценивается первым, частое уже не помещается в бюджет
+        QueryBudget budget;
+        budget.max_postings = 1;
+        const SearchResult result = server.FindTopDocumentsWithin(budget, "common rare"s);
+        ASSERT(result.is_partial);
+        ASSERT_EQUAL(result.postings_scored, 3u);
+        ASSERT_EQUAL(result.documents.size(), 3u);
+        ASSERT_EQUAL(result.documents[0].id, 2);
+        // минус-слова применяются и к неполному результату
+        ASSERT_EQUAL(server.FindTopDocumentsWithin(budget, "common rare -extra"s).documents.size(), 2u);
+    }
+    {
+        // полный блок засчитан и оценён целиком, включая последний постинг
+        QueryBudget budget;
+        budget.max_postings = POSTING_BLOCK_SIZE;
+        const SearchResult result = server.FindTopDocumentsWithin(budget, "common"s);
+        ASSERT(result.is_partial);
+        ASSERT_EQUAL(result.postings_scored, static_cast<size_t>(POSTING_BLOCK_SIZE));
+        ASSERT_EQUAL(result.documents[0].id, POSTING_BLOCK_SIZE - 1);
+    }
+    {
+        QueryBudget budget;
+        budget.max_time = 0s;
+        const SearchResult result = server.FindTopDocumentsWithin(budget, "common rare"s);
+        ASSERT(result.is_partial);
+        ASSERT(result.documents.empty());
+    }
+    {
+        QueryBudget budget;
+        budget.max_postings = 100;
+        const auto results = ProcessQueries(server, {"rare"s, "common rare"s, "+common +rare"s}, budget);
+        ASSERT_EQUAL(results.size(), 3u);
+        ASSERT(!results[0].is_partial);
+        ASSERT_EQUAL(results[0].documents.size(), 3u);
+        ASSERT(results[1].is_partial);
+        ASSERT(results[1].postings_scored < 303u);
+        ASSERT(!results[2].is_partial);
+        ASSERT_EQUAL(results[2].documents.size(), 3u);
     }
-    return queries;
 }
+
+void TestSearchServer() {
+    RUN_TEST(TestSplitWords);
+    RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
+    RUN_TEST(TestAddDocument);
+    RUN_TEST(TestMinusWords);
+    RUN_TEST(TestMatchedDocuments);
+    RUN_TEST(TestSortFindedDocumentsByRelevance);
+    RUN_TEST(TestRatings);
+    RUN_TEST(TestRelevances);
+    RUN_TEST(TestSearchByStatus);
+    RUN_TEST(TestSearchByPredicate);
+    RUN_TEST(TestFindTopDocumentsAsync);
+    RUN_TEST(TestRequestStats);
+    RUN_TEST(TestPaginator);
+    RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestMetrics);
+    RUN_TEST(TestWorkloadGenerator);
+    RUN_TEST(TestQueryProfile);
+    RUN_TEST(TestDocumentFilters);
+    RUN_TEST(TestSetDocumentStatus);
+    RUN_TEST(TestImpactIndex);
+    RUN_TEST(TestBooleanQuery);
+    RUN_TEST(TestPrefixQuery);
+    RUN_TEST(TestFuzzyQuery);
+    RUN_TEST(TestRankingModels);
+    RUN_TEST(TestShardedSearchServer);
+    RUN_TEST(TestRpcProtocol);
+#ifdef __linux__
+    RUN_TEST(TestRpcServerBackpressure);
+#endif
+    RUN_TEST(TestIngest);
+    RUN_TEST(TestMemoryStats);
+    RUN_TEST(TestScoreAccumulator);
+    RUN_TEST(TestStopWords);
+    RUN_TEST(TestAnalyzer);
+    RUN_TEST(TestIndexStatistics);
+    RUN_TEST(TestRemoveDocuments);
+    RUN_TEST(TestQueryBudget);
+}
+
+
+void AddDocument(SearchServer &search_server, int document_id, const string &document, DocumentStatus status,
+                 const vector<int> &ratings) {
+    search_server.AddDocument(document_id, document, status, ratings);
+
+}
+// --------- Окончание модульных тестов поисковой системы -----------
+
+
+// ----------Добавляем параллельность-------------
+
+
+
+
+
 template <typename ExecutionPolicy>
 void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
     LOG_DURATION(mark);
@@ -457,6 +1709,7 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
 }
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 int main() {
+    TestSearchServer();
     mt19937 generator;
     const auto dictionary = GenerateDictionary(generator, 1000, 100);
     const auto documents = GenerateQueries(generator, dictionary, 10'000, 100);
@@ -0,0 +1,53 @@
+#include "memory_resources.h"
+
+namespace
+{
+void PrintMemoryStats(std::ostream &out, const char *name, const MemoryStats &stats)
+{
+    out << name << ": live " << stats.live_bytes / 1024 << " KiB (peak " << stats.peak_live_bytes / 1024
+        << "), reserved " << stats.reserved_bytes / 1024 << " KiB (peak " << stats.peak_reserved_bytes / 1024
+        << "), allocations " << stats.allocation_count << std::endl;
+}
+}
+
+void *CountingMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+    void *result = upstream_->allocate(bytes, alignment);
+    allocation_count_.fetch_add(1, std::memory_order_relaxed);
+    const size_t in_use = bytes_in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peak_bytes_in_use_.load(std::memory_order_relaxed);
+    while (in_use > peak && !peak_bytes_in_use_.compare_exchange_weak(peak, in_use, std::memory_order_relaxed))
+    {
+    }
+    return result;
+}
+
+void CountingMemoryResource::do_deallocate(void *p, size_t bytes, size_t alignment)
+{
+    upstream_->deallocate(p, bytes, alignment);
+    bytes_in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool CountingMemoryResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+MemoryStats NodePool::GetStats() const
+{
+    MemoryStats result;
+    result.live_bytes = live_.GetBytesInUse();
+    result.peak_live_bytes = live_.GetPeakBytesInUse();
+    result.reserved_bytes = reserved_.GetBytesInUse();
+    result.peak_reserved_bytes = reserved_.GetPeakBytesInUse();
+    result.allocation_count = live_.GetAllocationCount();
+    return result;
+}
+
+void IndexMemoryStats::Print(std::ostream &out) const
+{
+    PrintMemoryStats(out, "dictionary", dictionary);
+    PrintMemoryStats(out, "postings", postings);
+    PrintMemoryStats(out, "forward index", forward_index);
+    PrintMemoryStats(out, "query arenas", query_arenas);
+}
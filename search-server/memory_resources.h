@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+
+// Снимок одного аллокатора. live_bytes - то, что сейчас занято узлами контейнеров,
+// reserved_bytes - то, что аллокатор взял у системы; их разница - потери на пулах и выравнивании
+struct MemoryStats
+{
+    size_t live_bytes = 0;
+    size_t peak_live_bytes = 0;
+    size_t reserved_bytes = 0;
+    size_t peak_reserved_bytes = 0;
+    size_t allocation_count = 0;
+};
+
+// Считает байты, прошедшие через upstream. Счётчики атомарные, ресурс потокобезопасен,
+// если потокобезопасен upstream
+class CountingMemoryResource : public std::pmr::memory_resource
+{
+public:
+    explicit CountingMemoryResource(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : upstream_(upstream)
+    {
+    }
+
+    size_t GetBytesInUse() const
+    {
+        return bytes_in_use_.load(std::memory_order_relaxed);
+    }
+
+    size_t GetPeakBytesInUse() const
+    {
+        return peak_bytes_in_use_.load(std::memory_order_relaxed);
+    }
+
+    size_t GetAllocationCount() const
+    {
+        return allocation_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    std::pmr::memory_resource *upstream_;
+    std::atomic<size_t> bytes_in_use_ = 0;
+    std::atomic<size_t> peak_bytes_in_use_ = 0;
+    std::atomic<size_t> allocation_count_ = 0;
+};
+
+// Пул узлов индекса: узлы одного размера берутся из общих блоков, а не по одному из кучи.
+// Пул синхронизированный - параллельный RemoveDocument освобождает узлы из нескольких потоков
+class NodePool
+{
+public:
+    NodePool() : pool_(&reserved_), live_(&pool_)
+    {
+    }
+
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    std::pmr::memory_resource *GetResource()
+    {
+        return &live_;
+    }
+
+    MemoryStats GetStats() const;
+
+private:
+    CountingMemoryResource reserved_;
+    std::pmr::synchronized_pool_resource pool_;
+    CountingMemoryResource live_;
+};
+
+// Арена временных структур одного запроса: всё выделяется сдвигом указателя и освобождается
+// разом в деструкторе. Первые INLINE_SIZE байт лежат на стеке, дальше - блоки из upstream
+class QueryArena
+{
+public:
+    static const size_t INLINE_SIZE = 4096;
+
+    explicit QueryArena(std::pmr::memory_resource *upstream)
+        : arena_(buffer_.data(), buffer_.size(), upstream)
+    {
+    }
+
+    QueryArena(const QueryArena &) = delete;
+    QueryArena &operator=(const QueryArena &) = delete;
+
+    std::pmr::memory_resource *GetResource()
+    {
+        return &arena_;
+    }
+
+private:
+    alignas(std::max_align_t) std::array<std::byte, INLINE_SIZE> buffer_;
+    std::pmr::monotonic_buffer_resource arena_;
+};
+
+// Память сервера по аллокаторам
+struct IndexMemoryStats
+{
+    // узлы word_to_document_freqs_
+    MemoryStats dictionary;
+    // списки постингов внутри них
+    MemoryStats postings;
+    // прямой индекс document2words_freqs
+    MemoryStats forward_index;
+    // блоки арен запросов, не поместившиеся в INLINE_SIZE
+    MemoryStats query_arenas;
+
+    void Print(std::ostream &out) const;
+};
@@ -0,0 +1,342 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+// Ячейки одного потока: пишет только владелец, поэтому инкремент - load + store без lock-префикса
+struct ThreadMetrics
+{
+    array<atomic<uint64_t>, COUNTER_COUNT> counters{};
+    array<array<atomic<uint64_t>, HISTOGRAM_BUCKET_COUNT>, PHASE_COUNT> buckets{};
+    array<atomic<uint64_t>, PHASE_COUNT> sums_ns{};
+};
+
+void AddRelaxed(atomic<uint64_t> &cell, uint64_t value)
+{
+    cell.store(cell.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+// destination += source, source обнуляется
+void MoveCells(ThreadMetrics &destination, ThreadMetrics &source)
+{
+    const auto move_cell = [](atomic<uint64_t> &to, atomic<uint64_t> &from)
+    {
+        AddRelaxed(to, from.load(memory_order_relaxed));
+        from.store(0, memory_order_relaxed);
+    };
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        move_cell(destination.counters[i], source.counters[i]);
+    }
+    for (int phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket)
+        {
+            move_cell(destination.buckets[phase][bucket], source.buckets[phase][bucket]);
+        }
+        move_cell(destination.sums_ns[phase], source.sums_ns[phase]);
+    }
+}
+
+// Реестр ячеек: число ячеек не больше числа одновременно живших потоков. Завершившийся поток
+// переносит свои данные в retired и освобождает ячейку для следующего
+mutex registry_mutex;
+struct Registry
+{
+    vector<unique_ptr<ThreadMetrics>> slots;
+    vector<ThreadMetrics *> free_slots;
+    ThreadMetrics retired;
+};
+
+Registry &GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+class ThreadMetricsHolder
+{
+public:
+    ThreadMetricsHolder()
+    {
+        lock_guard guard(registry_mutex);
+        Registry &registry = GetRegistry();
+        if (registry.free_slots.empty())
+        {
+            registry.slots.push_back(make_unique<ThreadMetrics>());
+            metrics_ = registry.slots.back().get();
+        }
+        else
+        {
+            metrics_ = registry.free_slots.back();
+            registry.free_slots.pop_back();
+        }
+    }
+
+    ~ThreadMetricsHolder()
+    {
+        lock_guard guard(registry_mutex);
+        Registry &registry = GetRegistry();
+        MoveCells(registry.retired, *metrics_);
+        registry.free_slots.push_back(metrics_);
+    }
+
+    ThreadMetricsHolder(const ThreadMetricsHolder &) = delete;
+    ThreadMetricsHolder &operator=(const ThreadMetricsHolder &) = delete;
+
+    ThreadMetrics &Get()
+    {
+        return *metrics_;
+    }
+
+private:
+    ThreadMetrics *metrics_;
+};
+
+ThreadMetrics &GetThreadMetrics()
+{
+    thread_local ThreadMetricsHolder holder;
+    return holder.Get();
+}
+
+void AddTo(MetricsSnapshot &result, const ThreadMetrics &metrics)
+{
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        result.counters[i] += metrics.counters[i].load(memory_order_relaxed);
+    }
+    for (int phase = 0; phase < PHASE_COUNT; ++phase)
+    {
+        LatencyHistogram &histogram = result.phases[phase];
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket)
+        {
+            const uint64_t count = metrics.buckets[phase][bucket].load(memory_order_relaxed);
+            histogram.buckets[bucket] += count;
+            histogram.count += count;
+        }
+        histogram.sum_ns += metrics.sums_ns[phase].load(memory_order_relaxed);
+    }
+}
+
+void Clear(ThreadMetrics &metrics)
+{
+    for (auto &counter : metrics.counters)
+    {
+        counter.store(0, memory_order_relaxed);
+    }
+    for (auto &phase_buckets : metrics.buckets)
+    {
+        for (auto &bucket : phase_buckets)
+        {
+            bucket.store(0, memory_order_relaxed);
+        }
+    }
+    for (auto &sum : metrics.sums_ns)
+    {
+        sum.store(0, memory_order_relaxed);
+    }
+}
+
+int FindHighestBit(uint64_t value)
+{
+    int result = 0;
+    while (value >>= 1)
+    {
+        ++result;
+    }
+    return result;
+}
+}
+
+atomic_bool Metrics::enabled_{false};
+
+int LatencyHistogram::GetBucket(uint64_t value_ns)
+{
+    if (value_ns < HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return static_cast<int>(value_ns);
+    }
+    const int exponent = FindHighestBit(value_ns);
+    const int sub_bucket = static_cast<int>((value_ns >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKET_COUNT - 1));
+    return (exponent - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(int bucket)
+{
+    if (bucket < HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        return bucket;
+    }
+    const int exponent = bucket / HISTOGRAM_SUB_BUCKET_COUNT + HISTOGRAM_SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = bucket % HISTOGRAM_SUB_BUCKET_COUNT;
+    const int shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+    return ((HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket + 1) << shift) - 1;
+}
+
+chrono::nanoseconds LatencyHistogram::GetQuantile(double q) const
+{
+    if (count == 0)
+    {
+        return chrono::nanoseconds(0);
+    }
+    const uint64_t rank = static_cast<uint64_t>(clamp(q, 0.0, 1.0) * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKET_COUNT; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+        {
+            return chrono::nanoseconds(GetBucketUpperBound(bucket));
+        }
+    }
+    return chrono::nanoseconds(GetBucketUpperBound(HISTOGRAM_BUCKET_COUNT - 1));
+}
+
+void Metrics::Increment(MetricCounter counter, uint64_t value)
+{
+    AddRelaxed(GetThreadMetrics().counters[static_cast<int>(counter)], value);
+}
+
+void Metrics::RecordDuration(MetricPhase phase, chrono::nanoseconds duration)
+{
+    const uint64_t value_ns = static_cast<uint64_t>(max<int64_t>(duration.count(), 0));
+    ThreadMetrics &metrics = GetThreadMetrics();
+    const int phase_index = static_cast<int>(phase);
+    AddRelaxed(metrics.buckets[phase_index][LatencyHistogram::GetBucket(value_ns)], 1);
+    AddRelaxed(metrics.sums_ns[phase_index], value_ns);
+}
+
+MetricsSnapshot Metrics::Collect()
+{
+    MetricsSnapshot result;
+    lock_guard guard(registry_mutex);
+    // свободные ячейки обнулены и ничего не добавляют
+    for (const auto &metrics : GetRegistry().slots)
+    {
+        AddTo(result, *metrics);
+    }
+    AddTo(result, GetRegistry().retired);
+    return result;
+}
+
+// Не синхронизирован с пишущими потоками: вызывать, когда замеры не идут
+void Metrics::Reset()
+{
+    lock_guard guard(registry_mutex);
+    for (const auto &metrics : GetRegistry().slots)
+    {
+        Clear(*metrics);
+    }
+    Clear(GetRegistry().retired);
+}
+
+size_t Metrics::GetThreadSlotCount()
+{
+    lock_guard guard(registry_mutex);
+    return GetRegistry().slots.size();
+}
+
+const char *Metrics::GetName(MetricPhase phase)
+{
+    switch (phase)
+    {
+    case MetricPhase::PARSE:
+        return "parse";
+    case MetricPhase::SCORING:
+        return "scoring";
+    case MetricPhase::MINUS_FILTER:
+        return "minus_filter";
+    case MetricPhase::TOP_K:
+        return "top_k";
+    case MetricPhase::ADD_DOCUMENT:
+        return "add_document";
+    case MetricPhase::REMOVE_DOCUMENT:
+        return "remove_document";
+    default:
+        return "unknown";
+    }
+}
+
+const char *Metrics::GetName(MetricCounter counter)
+{
+    switch (counter)
+    {
+    case MetricCounter::QUERIES:
+        return "queries";
+    case MetricCounter::POSTINGS_VISITED:
+        return "postings_visited";
+    case MetricCounter::DOCUMENTS_SCORED:
+        return "documents_scored";
+    case MetricCounter::DOCUMENTS_ADDED:
+        return "documents_added";
+    case MetricCounter::DOCUMENTS_REMOVED:
+        return "documents_removed";
+    default:
+        return "unknown";
+    }
+}
+
+void MetricsSnapshot::PrintText(ostream &out) const
+{
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        out << Metrics::GetName(static_cast<MetricCounter>(i)) << ": "s << counters[i] << '\n';
+    }
+    for (int i = 0; i < PHASE_COUNT; ++i)
+    {
+        const LatencyHistogram &histogram = phases[i];
+        out << Metrics::GetName(static_cast<MetricPhase>(i)) << ": count="s << histogram.count;
+        if (histogram.count > 0)
+        {
+            out << " mean="s << histogram.sum_ns / histogram.count << "ns"s
+                << " p50="s << histogram.GetQuantile(0.5).count() << "ns"s
+                << " p99="s << histogram.GetQuantile(0.99).count() << "ns"s
+                << " max="s << histogram.GetQuantile(1.0).count() << "ns"s;
+        }
+        out << '\n';
+    }
+}
+
+void MetricsSnapshot::PrintPrometheus(ostream &out) const
+{
+    for (int i = 0; i < COUNTER_COUNT; ++i)
+    {
+        const string name = "search_server_"s + Metrics::GetName(static_cast<MetricCounter>(i)) + "_total"s;
+        out << "# TYPE "s << name << " counter\n"s;
+        out << name << ' ' << counters[i] << '\n';
+    }
+
+    // Корзины Prometheus - только границы степеней двойки, от 1 мкс до ~69 с
+    const int first_exponent = 10;
+    const int last_exponent = 36;
+    out << "# TYPE search_server_phase_duration_seconds histogram\n"s;
+    for (int i = 0; i < PHASE_COUNT; ++i)
+    {
+        const LatencyHistogram &histogram = phases[i];
+        const char *phase = Metrics::GetName(static_cast<MetricPhase>(i));
+        uint64_t cumulative = 0;
+        int bucket = 0;
+        for (int exponent = first_exponent; exponent <= last_exponent; ++exponent)
+        {
+            const uint64_t bound_ns = uint64_t{1} << exponent;
+            while (bucket < HISTOGRAM_BUCKET_COUNT && LatencyHistogram::GetBucketUpperBound(bucket) < bound_ns)
+            {
+                cumulative += histogram.buckets[bucket++];
+            }
+            out << "search_server_phase_duration_seconds_bucket{phase=\""s << phase << "\",le=\""s
+                << bound_ns * 1e-9 << "\"} "s << cumulative << '\n';
+        }
+        out << "search_server_phase_duration_seconds_bucket{phase=\""s << phase << "\",le=\"+Inf\"} "s
+            << histogram.count << '\n';
+        out << "search_server_phase_duration_seconds_sum{phase=\""s << phase << "\"} "s
+            << histogram.sum_ns * 1e-9 << '\n';
+        out << "search_server_phase_duration_seconds_count{phase=\""s << phase << "\"} "s
+            << histogram.count << '\n';
+    }
+}
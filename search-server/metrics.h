@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// Счётчики и гистограммы длительностей горячих участков сервера.
+// Каждый поток пишет в свой набор ячеек, Metrics::Collect суммирует их по требованию.
+// Сбор включается Metrics::SetEnabled(true); при выключенном сборе точка замера стоит
+// одну relaxed-загрузку флага. С -DSEARCH_SERVER_NO_METRICS макросы не генерируют кода.
+
+enum class MetricPhase
+{
+    PARSE,
+    SCORING,
+    MINUS_FILTER,
+    TOP_K,
+    ADD_DOCUMENT,
+    REMOVE_DOCUMENT,
+    COUNT,
+};
+
+enum class MetricCounter
+{
+    QUERIES,
+    POSTINGS_VISITED,
+    DOCUMENTS_SCORED,
+    DOCUMENTS_ADDED,
+    DOCUMENTS_REMOVED,
+    COUNT,
+};
+
+const int PHASE_COUNT = static_cast<int>(MetricPhase::COUNT);
+const int COUNTER_COUNT = static_cast<int>(MetricCounter::COUNT);
+
+// Лог-линейная гистограмма в стиле HDR: 2^HISTOGRAM_SUB_BUCKET_BITS корзин на каждую степень двойки,
+// относительная ошибка не больше 1 / 2^HISTOGRAM_SUB_BUCKET_BITS
+const int HISTOGRAM_SUB_BUCKET_BITS = 3;
+const int HISTOGRAM_SUB_BUCKET_COUNT = 1 << HISTOGRAM_SUB_BUCKET_BITS;
+const int HISTOGRAM_BUCKET_COUNT = (64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKET_COUNT;
+
+struct LatencyHistogram
+{
+    std::array<uint64_t, HISTOGRAM_BUCKET_COUNT> buckets{};
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+
+    static int GetBucket(uint64_t value_ns);
+    static uint64_t GetBucketUpperBound(int bucket);
+
+    std::chrono::nanoseconds GetQuantile(double q) const;
+};
+
+struct MetricsSnapshot
+{
+    std::array<uint64_t, COUNTER_COUNT> counters{};
+    std::array<LatencyHistogram, PHASE_COUNT> phases{};
+
+    uint64_t Get(MetricCounter counter) const
+    {
+        return counters[static_cast<int>(counter)];
+    }
+
+    const LatencyHistogram &Get(MetricPhase phase) const
+    {
+        return phases[static_cast<int>(phase)];
+    }
+
+    void PrintText(std::ostream &out) const;
+    void PrintPrometheus(std::ostream &out) const;
+};
+
+class Metrics
+{
+public:
+    static void SetEnabled(bool enabled)
+    {
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    static bool IsEnabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    static void Increment(MetricCounter counter, uint64_t value = 1);
+    static void RecordDuration(MetricPhase phase, std::chrono::nanoseconds duration);
+
+    static MetricsSnapshot Collect();
+    static void Reset();
+    // ячейки потоков в реестре: не больше, чем потоков, одновременно писавших метрики
+    static size_t GetThreadSlotCount();
+
+    static const char *GetName(MetricPhase phase);
+    static const char *GetName(MetricCounter counter);
+
+private:
+    static std::atomic_bool enabled_;
+};
+
+class MetricTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit MetricTimer(MetricPhase phase) : phase_(phase), enabled_(Metrics::IsEnabled())
+    {
+        if (enabled_)
+        {
+            start_time_ = Clock::now();
+        }
+    }
+
+    MetricTimer(const MetricTimer &) = delete;
+    MetricTimer &operator=(const MetricTimer &) = delete;
+
+    ~MetricTimer()
+    {
+        if (enabled_)
+        {
+            Metrics::RecordDuration(phase_, Clock::now() - start_time_);
+        }
+    }
+
+private:
+    MetricPhase phase_;
+    bool enabled_;
+    Clock::time_point start_time_;
+};
+
+#ifdef SEARCH_SERVER_NO_METRICS
+#define METRIC_TIMER(phase)
+#define METRIC_INCREMENT(counter, value)
+#else
+#define METRIC_CONCAT_INTERNAL(X, Y) X##Y
+#define METRIC_CONCAT(X, Y) METRIC_CONCAT_INTERNAL(X, Y)
+#define METRIC_TIMER(phase) MetricTimer METRIC_CONCAT(metricTimer, __LINE__)(phase)
+#define METRIC_INCREMENT(counter, value)          \
+    do                                            \
+    {                                             \
+        if (Metrics::IsEnabled())                 \
+        {                                         \
+            Metrics::Increment((counter), (value)); \
+        }                                         \
+    } while (false)
+#endif
@@ -1,7 +1,9 @@
 #pragma once // помогает так же от двойной реализации
 
+#include <algorithm>
 #include <iostream>
-#include <vector>
+#include <iterator>
+#include <type_traits>
 
 
 
@@ -11,46 +13,122 @@ struct IteratorRange
     It begin;
     It end;
 
-    int size()
+    int size() const
     {
-        return end - begin;
+        return static_cast<int>(std::distance(begin, end));
     }
 };
 
+// Сдвигает it не дальше чем на count шагов и не дальше end
+template <typename It>
+It AdvanceBounded(It it, It end, size_t count)
+{
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category>)
+    {
+        return it + std::min<typename std::iterator_traits<It>::difference_type>(end - it, count);
+    }
+    else
+    {
+        for (; count > 0 && it != end; --count)
+        {
+            ++it;
+        }
+        return it;
+    }
+}
 
 
+// Страницы не хранятся: границы очередной страницы вычисляются при переходе к ней.
+// Для итераторов произвольного доступа GetPage и GetPageCount работают за O(1).
 template <typename It>
 class Paginator
 {
 public:
-    std::vector<IteratorRange<It>> pages;
-    size_t step;
-    size_t diff;
-    explicit Paginator(It begin, It end, size_t size)
+    class PageIterator
     {
-        It iter = begin;
-        while (std::distance(iter, end) > 0)
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IteratorRange<It>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const IteratorRange<It> *;
+        using reference = const IteratorRange<It> &;
+
+        PageIterator(It begin, It end, size_t page_size)
+            : page_{begin, AdvanceBounded(begin, end, page_size)}, end_(end), page_size_(page_size)
         {
-            diff = std::distance(iter, end);
-            step = std::min(diff, size);
-            auto new_begin = iter;
-            std::advance(iter, step);
-
-            IteratorRange<It> range = {new_begin,
-                                       iter};
-            pages.push_back(range);
         }
+
+        reference operator*() const
+        {
+            return page_;
+        }
+
+        pointer operator->() const
+        {
+            return &page_;
+        }
+
+        PageIterator &operator++()
+        {
+            page_.begin = page_.end;
+            page_.end = AdvanceBounded(page_.begin, end_, page_size_);
+            return *this;
+        }
+
+        PageIterator operator++(int)
+        {
+            PageIterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const PageIterator &other) const
+        {
+            return page_.begin == other.page_.begin;
+        }
+
+        bool operator!=(const PageIterator &other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        IteratorRange<It> page_;
+        It end_;
+        size_t page_size_;
+    };
+
+    explicit Paginator(It begin, It end, size_t size)
+        : begin_(begin), end_(end), page_size_(std::max<size_t>(size, 1))
+    {
+    }
+
+    PageIterator begin() const
+    {
+        return PageIterator(begin_, end_, page_size_);
     }
 
-    auto begin() const
+    PageIterator end() const
     {
-        return pages.begin();
+        return PageIterator(end_, end_, page_size_);
     }
 
-    auto end() const
+    size_t GetPageCount() const
     {
-        return pages.end();
+        const size_t item_count = static_cast<size_t>(std::distance(begin_, end_));
+        return (item_count + page_size_ - 1) / page_size_;
     }
+
+    IteratorRange<It> GetPage(size_t page_index) const
+    {
+        const It page_begin = AdvanceBounded(begin_, end_, page_index * page_size_);
+        return {page_begin, AdvanceBounded(page_begin, end_, page_size_)};
+    }
+
+private:
+    It begin_;
+    It end_;
+    size_t page_size_;
 };
 
 
@@ -67,4 +145,4 @@ auto Paginate(const Container &c, size_t page_size)
 {
     Paginator p(begin(c), end(c), page_size);
     return p;
-}
\ No newline at end of file
+}
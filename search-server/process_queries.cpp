@@ -12,6 +12,15 @@ std::vector<std::vector<Document>> ProcessQueries(
     return result;
 }
 
+std::vector<SearchResult> ProcessQueries(
+        const SearchServer& search_server,
+        const std::vector<std::string>& queries,
+        const QueryBudget& budget){
+    std::vector<SearchResult> result(queries.size());
+    std::transform(std::execution::par, queries.begin(), queries.end(), result.begin(),
+              [&search_server, &budget](const std::string& query) { return search_server.FindTopDocumentsWithin(budget, query); });
+    return result;
+}
 
 
 std::vector<Document> ProcessQueriesJoined(
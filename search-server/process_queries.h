@@ -10,6 +10,12 @@ std::vector<std::vector<Document>> ProcessQueries(
         const std::vector<std::string>& queries);
 
 
+// у каждого запроса свой бюджет, время отсчитывается от начала этого запроса
+std::vector<SearchResult> ProcessQueries(
+        const SearchServer& search_server,
+        const std::vector<std::string>& queries,
+        const QueryBudget& budget);
+
 std::vector<Document> ProcessQueriesJoined(
         const SearchServer& search_server,
         const std::vector<std::string>& queries);
\ No newline at end of file
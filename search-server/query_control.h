@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "document.h"
+
+// Токен отмены разделяется между вызывающим потоком и выполняющимся запросом
+class CancellationToken
+{
+public:
+    CancellationToken() : cancelled_(std::make_shared<std::atomic_bool>(false))
+    {
+    }
+
+    void Cancel() const
+    {
+        cancelled_->store(true, std::memory_order_relaxed);
+    }
+
+    bool IsCancelled() const
+    {
+        return cancelled_->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic_bool> cancelled_;
+};
+
+struct QueryDeadline
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point deadline = Clock::time_point::max();
+    CancellationToken token;
+
+    static QueryDeadline After(Clock::duration timeout)
+    {
+        QueryDeadline result;
+        result.deadline = Clock::now() + timeout;
+        return result;
+    }
+
+    bool IsExpired() const
+    {
+        return token.IsCancelled() || Clock::now() >= deadline;
+    }
+};
+
+// Предел работы одного запроса: время от его начала и число оценённых постингов плюс-слов.
+// Слова оцениваются по убыванию idf, так что прерванный запрос успевает учесть самые редкие;
+// минус-слова применяются всегда
+struct QueryBudget
+{
+    QueryDeadline::Clock::duration max_time = QueryDeadline::Clock::duration::max();
+    size_t max_postings = std::numeric_limits<size_t>::max();
+
+    // дедлайн запроса, начинающегося сейчас
+    QueryDeadline Start() const
+    {
+        return max_time == QueryDeadline::Clock::duration::max() ? QueryDeadline{} : QueryDeadline::After(max_time);
+    }
+};
+
+// is_partial == true: подсчёт прерван по дедлайну, отмене или бюджету, документы - лучшие из
+// обработанных; false - результат точный
+struct SearchResult
+{
+    std::vector<Document> documents;
+    bool is_partial = false;
+    // постинги плюс-слов, прочитанные до остановки
+    size_t postings_scored = 0;
+};
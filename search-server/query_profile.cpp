@@ -0,0 +1,23 @@
+#include "query_profile.h"
+
+using namespace std;
+
+void QueryProfile::Print(ostream &out) const
+{
+    for (const TermProfile &term : plus_terms)
+    {
+        out << "+"s << term.term << ": postings="s << term.posting_count << " idf="s << term.inverse_document_freq << '\n';
+    }
+    for (const TermProfile &term : minus_terms)
+    {
+        out << "-"s << term.term << ": postings="s << term.posting_count << '\n';
+    }
+    out << "postings_visited="s << postings_visited
+        << " documents_scored="s << documents_scored
+        << " predicate_rejects="s << predicate_rejects
+        << " minus_exclusions="s << minus_exclusions << '\n';
+    for (MetricPhase phase : {MetricPhase::PARSE, MetricPhase::SCORING, MetricPhase::MINUS_FILTER, MetricPhase::TOP_K})
+    {
+        out << Metrics::GetName(phase) << ": "s << Get(phase).count() << " ns\n"s;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "document.h"
+#include "metrics.h"
+
+struct TermProfile
+{
+    std::string term;
+    size_t posting_count = 0;
+    double inverse_document_freq = 0.0;
+};
+
+// Разбор одного запроса: во что ушло время и сколько работы сделано
+struct QueryProfile
+{
+    std::vector<TermProfile> plus_terms;
+    std::vector<TermProfile> minus_terms;
+    size_t postings_visited = 0;
+    size_t documents_scored = 0;
+    size_t predicate_rejects = 0;
+    size_t minus_exclusions = 0;
+    // индексируются MetricPhase: PARSE, SCORING, MINUS_FILTER, TOP_K
+    std::array<std::chrono::nanoseconds, PHASE_COUNT> phase_durations{};
+
+    std::chrono::nanoseconds Get(MetricPhase phase) const
+    {
+        return phase_durations[static_cast<int>(phase)];
+    }
+
+    void Print(std::ostream &out) const;
+};
+
+struct ProfiledSearchResult
+{
+    std::vector<Document> documents;
+    QueryProfile profile;
+};
+
+class PhaseTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PhaseTimer(std::chrono::nanoseconds &duration) : duration_(duration)
+    {
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+    ~PhaseTimer()
+    {
+        duration_ += Clock::now() - start_time_;
+    }
+
+private:
+    std::chrono::nanoseconds &duration_;
+    const Clock::time_point start_time_ = Clock::now();
+};
+
+// Ничего не замеряет; возвращается из TimePhase, когда профилирование выключено
+struct NoPhaseTimer
+{
+};
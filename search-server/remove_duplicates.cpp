@@ -0,0 +1,242 @@
+#include "remove_duplicates.h"
+
+#include <algorithm>
+#include <execution>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+uint64_t Mix(uint64_t value)
+{
+    // splitmix64
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+}
+
+DuplicateDetector::DuplicateDetector(DuplicateDetectorOptions options)
+    : options_(options)
+{
+    if (options_.band_count * options_.rows_per_band != MIN_HASH_COUNT)
+    {
+        throw invalid_argument("band_count * rows_per_band must be equal to MIN_HASH_COUNT");
+    }
+    if (!IsExactOnly())
+    {
+        bands_.resize(options_.band_count);
+    }
+}
+
+DuplicateDetector::Signature DuplicateDetector::ComputeSignature(vector<string_view> words)
+{
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+
+    Signature signature;
+    signature.exact_hash = {Mix(words.size()), Mix(~words.size())};
+    signature.min_hashes.fill(UINT64_MAX);
+    for (const string_view word : words)
+    {
+        const uint64_t word_hash = hash<string_view>{}(word);
+        signature.exact_hash.first = Mix(signature.exact_hash.first ^ word_hash);
+        signature.exact_hash.second = Mix(signature.exact_hash.second + Mix(word_hash ^ 0x5bd1e995ULL));
+        for (int i = 0; i < MIN_HASH_COUNT; ++i)
+        {
+            signature.min_hashes[i] = min(signature.min_hashes[i], Mix(word_hash ^ Mix(i)));
+        }
+    }
+    return signature;
+}
+
+optional<int> DuplicateDetector::FindDuplicate(const Signature &signature) const
+{
+    if (const auto it = exact_.find(signature.exact_hash); it != exact_.end())
+    {
+        return it->second;
+    }
+    if (IsExactOnly())
+    {
+        return nullopt;
+    }
+
+    optional<int> result;
+    for (int band = 0; band < options_.band_count; ++band)
+    {
+        const auto it = bands_[band].find(ComputeBandHash(signature, band));
+        if (it == bands_[band].end())
+        {
+            continue;
+        }
+        for (const int candidate_id : it->second)
+        {
+            if ((!result || candidate_id < *result)
+                && EstimateSimilarity(signature.min_hashes, min_hashes_.at(candidate_id)) >= options_.similarity_threshold)
+            {
+                result = candidate_id;
+            }
+        }
+    }
+    return result;
+}
+
+void DuplicateDetector::Insert(int document_id, const Signature &signature)
+{
+    exact_.emplace(signature.exact_hash, document_id);
+    exact_hashes_[document_id] = signature.exact_hash;
+    if (IsExactOnly())
+    {
+        return;
+    }
+    for (int band = 0; band < options_.band_count; ++band)
+    {
+        bands_[band][ComputeBandHash(signature, band)].push_back(document_id);
+    }
+    min_hashes_[document_id] = signature.min_hashes;
+}
+
+bool DuplicateDetector::Erase(int document_id)
+{
+    const auto it = exact_hashes_.find(document_id);
+    if (it == exact_hashes_.end())
+    {
+        return false;
+    }
+    // тот же хеш мог остаться за другим документом, вставленным раньше
+    if (const auto exact_it = exact_.find(it->second); exact_it != exact_.end() && exact_it->second == document_id)
+    {
+        exact_.erase(exact_it);
+    }
+    if (!IsExactOnly())
+    {
+        const auto min_hashes_it = min_hashes_.find(document_id);
+        const Signature signature{it->second, min_hashes_it->second};
+        for (int band = 0; band < options_.band_count; ++band)
+        {
+            const auto band_it = bands_[band].find(ComputeBandHash(signature, band));
+            vector<int> &ids = band_it->second;
+            ids.erase(remove(ids.begin(), ids.end(), document_id), ids.end());
+            if (ids.empty())
+            {
+                bands_[band].erase(band_it);
+            }
+        }
+        min_hashes_.erase(min_hashes_it);
+    }
+    exact_hashes_.erase(it);
+    return true;
+}
+
+bool DuplicateDetector::IsExactOnly() const
+{
+    return options_.similarity_threshold >= 1.0;
+}
+
+uint64_t DuplicateDetector::ComputeBandHash(const Signature &signature, int band) const
+{
+    uint64_t result = Mix(band);
+    for (int row = 0; row < options_.rows_per_band; ++row)
+    {
+        result = Mix(result ^ signature.min_hashes[band * options_.rows_per_band + row]);
+    }
+    return result;
+}
+
+double DuplicateDetector::EstimateSimilarity(const MinHashes &lhs, const MinHashes &rhs)
+{
+    int equal_count = 0;
+    for (int i = 0; i < MIN_HASH_COUNT; ++i)
+    {
+        equal_count += lhs[i] == rhs[i];
+    }
+    return static_cast<double>(equal_count) / MIN_HASH_COUNT;
+}
+
+vector<int> FindDuplicates(const SearchServer &search_server, DuplicateDetectorOptions options)
+{
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+
+    // сигнатуры считаются параллельно, поиск идёт по возрастанию id
+    vector<DuplicateDetector::Signature> signatures(document_ids.size());
+    transform(execution::par, document_ids.begin(), document_ids.end(), signatures.begin(),
+              [&search_server](int document_id)
+              {
+                  const auto &word_freqs = search_server.GetWordFrequencies(document_id);
+                  vector<string_view> words;
+                  words.reserve(word_freqs.size());
+                  // прямой индекс хранит и стоп-слова
+                  for (const auto &[word, _] : word_freqs)
+                  {
+                      if (!search_server.IsStopWord(word))
+                      {
+                          words.push_back(word);
+                      }
+                  }
+                  return DuplicateDetector::ComputeSignature(move(words));
+              });
+
+    DuplicateDetector detector(options);
+    vector<int> duplicates;
+    for (size_t i = 0; i < document_ids.size(); ++i)
+    {
+        if (detector.FindDuplicate(signatures[i]))
+        {
+            duplicates.push_back(document_ids[i]);
+        }
+        else
+        {
+            detector.Insert(document_ids[i], signatures[i]);
+        }
+    }
+    return duplicates;
+}
+
+void RemoveDuplicates(SearchServer &search_server)
+{
+    RemoveDuplicates(search_server, DuplicateDetectorOptions{});
+}
+
+void RemoveDuplicates(SearchServer &search_server, DuplicateDetectorOptions options)
+{
+    const vector<int> duplicates = FindDuplicates(search_server, options);
+    for (int document_id : duplicates)
+    {
+        cout << "Found duplicate document id " << document_id << endl;
+    }
+    search_server.RemoveDocuments(duplicates);
+}
+
+bool AddDocumentUnlessDuplicate(SearchServer &search_server, DuplicateDetector &detector, int document_id,
+                                const string &document, DocumentStatus status, const vector<int> &ratings)
+{
+    // слова берутся так же, как их проиндексирует сервер, с учётом анализатора
+    TokenizedDocument tokenized = search_server.TokenizeDocument(document_id, document, status, ratings);
+    vector<string_view> words;
+    for (const auto &[offset, size] : tokenized.words)
+    {
+        const string_view word = string_view(tokenized.text).substr(offset, size);
+        if (!search_server.IsStopWord(word))
+        {
+            words.push_back(word);
+        }
+    }
+    const auto signature = DuplicateDetector::ComputeSignature(move(words));
+    if (detector.FindDuplicate(signature))
+    {
+        return false;
+    }
+    search_server.AddDocument(move(tokenized));
+    detector.Insert(document_id, signature);
+    return true;
+}
+
+void RemoveDocument(SearchServer &search_server, DuplicateDetector &detector, int document_id)
+{
+    search_server.RemoveDocument(document_id);
+    detector.Erase(document_id);
+}
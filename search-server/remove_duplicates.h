@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "search_server.h"
+
+const int MIN_HASH_COUNT = 64;
+
+struct DuplicateDetectorOptions
+{
+    // 1.0 - только точные дубликаты (одинаковое множество слов)
+    double similarity_threshold = 1.0;
+    // band_count * rows_per_band должно равняться MIN_HASH_COUNT
+    int band_count = 16;
+    int rows_per_band = 4;
+};
+
+// Индекс дубликатов: точные ищутся по хешу отсортированного множества слов,
+// похожие - по MinHash-сигнатурам с LSH-разбиением на полосы. Документ, удалённый из сервера,
+// нужно стереть и отсюда, иначе его текст останется "занятым"; см. RemoveDocument ниже
+class DuplicateDetector
+{
+public:
+    using MinHashes = std::array<uint64_t, MIN_HASH_COUNT>;
+
+    struct Signature
+    {
+        std::pair<uint64_t, uint64_t> exact_hash;
+        MinHashes min_hashes;
+    };
+
+    explicit DuplicateDetector(DuplicateDetectorOptions options = {});
+
+    // words могут повторяться и идти в любом порядке
+    static Signature ComputeSignature(std::vector<std::string_view> words);
+
+    // id ранее добавленного документа, дубликатом которого является signature
+    std::optional<int> FindDuplicate(const Signature &signature) const;
+    void Insert(int document_id, const Signature &signature);
+    // false, если документа в индексе нет
+    bool Erase(int document_id);
+
+private:
+    struct PairHash
+    {
+        size_t operator()(const std::pair<uint64_t, uint64_t> &value) const
+        {
+            return static_cast<size_t>(value.first ^ (value.second * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+
+    bool IsExactOnly() const;
+    uint64_t ComputeBandHash(const Signature &signature, int band) const;
+    static double EstimateSimilarity(const MinHashes &lhs, const MinHashes &rhs);
+
+    DuplicateDetectorOptions options_;
+    std::unordered_map<std::pair<uint64_t, uint64_t>, int, PairHash> exact_;
+    std::vector<std::unordered_map<uint64_t, std::vector<int>>> bands_;
+    // сигнатура по id для Erase; min_hashes_ ведутся только для похожих дубликатов
+    std::unordered_map<int, std::pair<uint64_t, uint64_t>> exact_hashes_;
+    std::unordered_map<int, MinHashes> min_hashes_;
+};
+
+// id документов-дубликатов; из каждой группы остаётся документ с наименьшим id
+std::vector<int> FindDuplicates(const SearchServer &search_server, DuplicateDetectorOptions options = {});
+
+void RemoveDuplicates(SearchServer &search_server);
+void RemoveDuplicates(SearchServer &search_server, DuplicateDetectorOptions options);
+
+// Фильтр на входе индекса: документ не добавляется, если он дубликат уже добавленного
+bool AddDocumentUnlessDuplicate(SearchServer &search_server, DuplicateDetector &detector, int document_id,
+                                const std::string &document, DocumentStatus status, const std::vector<int> &ratings);
+// Удаляет документ из сервера и его сигнатуру из фильтра: тот же текст снова можно добавить
+void RemoveDocument(SearchServer &search_server, DuplicateDetector &detector, int document_id);
@@ -7,42 +7,30 @@ RequestQueue::RequestQueue(const SearchServer &search_server) : server_(search_s
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string &raw_query, DocumentStatus status)
 {
+    const auto start_time = std::chrono::steady_clock::now();
     std::vector<Document> temp = server_.FindTopDocuments(raw_query, status);
-    QueryResult temp_query;
-    temp_query.count_documents = temp.size();
-    AddQueryResult(temp_query);
+    AddQueryResult(temp.size(), std::chrono::steady_clock::now() - start_time);
     return temp;
 }
 std::vector<Document> RequestQueue::AddFindRequest(const std::string &raw_query)
 {
+    const auto start_time = std::chrono::steady_clock::now();
     std::vector<Document> temp = server_.FindTopDocuments(raw_query);
-    QueryResult temp_query;
-    temp_query.count_documents = temp.size();
-    AddQueryResult(temp_query);
+    AddQueryResult(temp.size(), std::chrono::steady_clock::now() - start_time);
     return temp;
 }
 
 int RequestQueue::GetNoResultRequests() const
 {
-    return count_;
+    return static_cast<int>(stats_.GetSnapshot(StatsWindow::DAY).no_result_requests);
 }
 
-void RequestQueue::AddQueryResult(const QueryResult &query)
+RequestStatsSnapshot RequestQueue::GetStats(StatsWindow window) const
 {
-    if (requests_.size() >= min_in_day_)
-    {
-        QueryResult results = requests_.front();
-        requests_.pop_front();
-        if (results.count_documents == 0)
-        {
-            count_--;
-        }
-    }
-    if (query.count_documents == 0)
-    {
-        count_++;
-    }
-    requests_.push_back(query);
+    return stats_.GetSnapshot(window);
 }
 
-
+void RequestQueue::AddQueryResult(size_t count_documents, std::chrono::nanoseconds latency)
+{
+    stats_.Record(count_documents, latency);
+}
@@ -1,12 +1,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <vector>
-#include <deque>
 
 #include "search_server.h"
 #include "document.h"
+#include "request_stats.h"
 
+// Потокобезопасна: AddFindRequest можно вызывать из нескольких потоков одновременно
 class RequestQueue
 {
 public:
@@ -15,27 +17,21 @@ public:
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string &raw_query, DocumentPredicate document_predicate)
     {
+        const auto start_time = std::chrono::steady_clock::now();
         std::vector<Document> temp = server_.FindTopDocuments(raw_query, document_predicate);
-        QueryResult temp_query;
-        temp_query.count_documents = temp.size();
-        AddQueryResult(temp_query);
+        AddQueryResult(temp.size(), std::chrono::steady_clock::now() - start_time);
         return temp;
     }
     std::vector<Document> AddFindRequest(const std::string &raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(const std::string &raw_query);
 
+    // запросы без результата за последние сутки
     int GetNoResultRequests() const;
+    RequestStatsSnapshot GetStats(StatsWindow window) const;
 
 private:
-    struct QueryResult
-    {
-        unsigned long count_documents;
-    };
-
-    void AddQueryResult(const QueryResult &query);
+    void AddQueryResult(size_t count_documents, std::chrono::nanoseconds latency);
 
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
     const SearchServer &server_;
-    int count_ = 0;
-};
\ No newline at end of file
+    RequestStats stats_;
+};
@@ -0,0 +1,127 @@
+#include "request_stats.h"
+
+#include <algorithm>
+
+using namespace std;
+
+double RequestStatsSnapshot::GetNoResultRate() const
+{
+    if (requests == 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(no_result_requests) / requests;
+}
+
+chrono::microseconds RequestStatsSnapshot::GetLatencyQuantile(double q) const
+{
+    uint64_t total = 0;
+    for (uint64_t count : latency_histogram)
+    {
+        total += count;
+    }
+    if (total == 0)
+    {
+        return chrono::microseconds(0);
+    }
+    const uint64_t rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket)
+    {
+        seen += latency_histogram[bucket];
+        if (seen >= rank)
+        {
+            return chrono::microseconds(int64_t{2} << bucket);
+        }
+    }
+    return chrono::microseconds(int64_t{2} << (LATENCY_BUCKET_COUNT - 1));
+}
+
+void RequestStats::Record(size_t result_count, chrono::nanoseconds latency, Clock::time_point now)
+{
+    Slot &slot = AcquireSlot(ToMinute(now));
+    slot.requests.fetch_add(1, memory_order_relaxed);
+    if (result_count == 0)
+    {
+        slot.no_result_requests.fetch_add(1, memory_order_relaxed);
+    }
+    slot.latency_histogram[GetLatencyBucket(latency)].fetch_add(1, memory_order_relaxed);
+    const size_t result_bucket = std::min<size_t>(result_count, RESULT_COUNT_BUCKET_COUNT - 1);
+    slot.result_count_histogram[result_bucket].fetch_add(1, memory_order_relaxed);
+}
+
+RequestStatsSnapshot RequestStats::GetSnapshot(StatsWindow window, Clock::time_point now) const
+{
+    int64_t window_minutes = MINUTES_IN_DAY;
+    if (window == StatsWindow::MINUTE)
+    {
+        window_minutes = 1;
+    }
+    else if (window == StatsWindow::HOUR)
+    {
+        window_minutes = 60;
+    }
+
+    const int64_t current_minute = ToMinute(now);
+    RequestStatsSnapshot result;
+    for (const Slot &slot : slots_)
+    {
+        const int64_t minute = slot.minute.load(memory_order_acquire);
+        if (minute > current_minute || minute <= current_minute - window_minutes)
+        {
+            continue;
+        }
+        result.requests += slot.requests.load(memory_order_relaxed);
+        result.no_result_requests += slot.no_result_requests.load(memory_order_relaxed);
+        for (int i = 0; i < LATENCY_BUCKET_COUNT; ++i)
+        {
+            result.latency_histogram[i] += slot.latency_histogram[i].load(memory_order_relaxed);
+        }
+        for (int i = 0; i < RESULT_COUNT_BUCKET_COUNT; ++i)
+        {
+            result.result_count_histogram[i] += slot.result_count_histogram[i].load(memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+int64_t RequestStats::ToMinute(Clock::time_point time)
+{
+    return chrono::duration_cast<chrono::minutes>(time.time_since_epoch()).count();
+}
+
+int RequestStats::GetLatencyBucket(chrono::nanoseconds latency)
+{
+    uint64_t micros = static_cast<uint64_t>(std::max<int64_t>(chrono::duration_cast<chrono::microseconds>(latency).count(), 1));
+    int bucket = 0;
+    while (micros > 1 && bucket < LATENCY_BUCKET_COUNT - 1)
+    {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+RequestStats::Slot &RequestStats::AcquireSlot(int64_t minute)
+{
+    Slot &slot = slots_[minute % MINUTES_IN_DAY];
+    int64_t seen = slot.minute.load(memory_order_acquire);
+    while (seen < minute)
+    {
+        if (slot.minute.compare_exchange_weak(seen, minute, memory_order_acq_rel))
+        {
+            slot.requests.store(0, memory_order_relaxed);
+            slot.no_result_requests.store(0, memory_order_relaxed);
+            for (auto &counter : slot.latency_histogram)
+            {
+                counter.store(0, memory_order_relaxed);
+            }
+            for (auto &counter : slot.result_count_histogram)
+            {
+                counter.store(0, memory_order_relaxed);
+            }
+            break;
+        }
+    }
+    return slot;
+}
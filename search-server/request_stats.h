@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "search_server.h"
+
+enum class StatsWindow
+{
+    MINUTE,
+    HOUR,
+    DAY,
+};
+
+// корзина i гистограммы задержек: [2^i, 2^(i+1)) микросекунд, в нулевую попадает всё меньше 2 мкс
+const int LATENCY_BUCKET_COUNT = 24;
+const int RESULT_COUNT_BUCKET_COUNT = MAX_RESULT_DOCUMENT_COUNT + 1;
+
+struct RequestStatsSnapshot
+{
+    uint64_t requests = 0;
+    uint64_t no_result_requests = 0;
+    std::array<uint64_t, LATENCY_BUCKET_COUNT> latency_histogram{};
+    std::array<uint64_t, RESULT_COUNT_BUCKET_COUNT> result_count_histogram{};
+
+    double GetNoResultRate() const;
+    // верхняя граница корзины, в которую попал квантиль q
+    std::chrono::microseconds GetLatencyQuantile(double q) const;
+};
+
+// Статистика запросов по окнам реального времени.
+// Кольцо из поминутных слотов за сутки; запись - несколько relaxed-инкрементов без блокировок.
+// Слот переиспользуется через сутки: первый писатель новой минуты обнуляет его, поэтому
+// инкременты, совпавшие по времени со сбросом, могут потеряться - статистика приблизительная.
+class RequestStats
+{
+public:
+    using Clock = std::chrono::system_clock;
+
+    void Record(size_t result_count, std::chrono::nanoseconds latency, Clock::time_point now = Clock::now());
+
+    RequestStatsSnapshot GetSnapshot(StatsWindow window, Clock::time_point now = Clock::now()) const;
+
+private:
+    static const int MINUTES_IN_DAY = 1440;
+
+    struct Slot
+    {
+        std::atomic<int64_t> minute{-1};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> no_result_requests{0};
+        std::array<std::atomic<uint64_t>, LATENCY_BUCKET_COUNT> latency_histogram{};
+        std::array<std::atomic<uint64_t>, RESULT_COUNT_BUCKET_COUNT> result_count_histogram{};
+    };
+
+    static int64_t ToMinute(Clock::time_point time);
+    static int GetLatencyBucket(std::chrono::nanoseconds latency);
+    Slot &AcquireSlot(int64_t minute);
+
+    std::array<Slot, MINUTES_IN_DAY> slots_;
+};
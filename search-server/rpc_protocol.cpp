@@ -0,0 +1,254 @@
+#include "rpc_protocol.h"
+
+#include <algorithm>
+#include <cstring>
+#include <execution>
+#include <stdexcept>
+
+namespace
+{
+uint32_t DecodeUint32(std::string_view bytes)
+{
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i)
+    {
+        value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return value;
+}
+
+void EncodeUint32(uint32_t value, char *bytes)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+DocumentStatus ToStatus(uint8_t value)
+{
+    if (value >= DOCUMENT_STATUS_COUNT)
+    {
+        throw std::invalid_argument("Unknown document status");
+    }
+    return static_cast<DocumentStatus>(value);
+}
+
+bool IsWriteRequest(std::string_view frame)
+{
+    return frame.size() > RPC_LENGTH_SIZE
+           && static_cast<uint8_t>(frame[RPC_LENGTH_SIZE]) == static_cast<uint8_t>(RpcType::ADD_DOCUMENT);
+}
+}
+
+RpcWriter::RpcWriter(uint8_t type, uint32_t request_id)
+{
+    frame_.resize(RPC_LENGTH_SIZE);
+    WriteUint8(type);
+    WriteUint32(request_id);
+}
+
+RpcWriter &RpcWriter::WriteUint8(uint8_t value)
+{
+    frame_.push_back(static_cast<char>(value));
+    return *this;
+}
+
+RpcWriter &RpcWriter::WriteUint32(uint32_t value)
+{
+    char bytes[4];
+    EncodeUint32(value, bytes);
+    frame_.append(bytes, 4);
+    return *this;
+}
+
+RpcWriter &RpcWriter::WriteInt32(int32_t value)
+{
+    return WriteUint32(static_cast<uint32_t>(value));
+}
+
+RpcWriter &RpcWriter::WriteDouble(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    WriteUint32(static_cast<uint32_t>(bits));
+    return WriteUint32(static_cast<uint32_t>(bits >> 32));
+}
+
+RpcWriter &RpcWriter::WriteString(std::string_view value)
+{
+    WriteUint32(static_cast<uint32_t>(value.size()));
+    frame_.append(value);
+    return *this;
+}
+
+std::string RpcWriter::Finish()
+{
+    EncodeUint32(static_cast<uint32_t>(frame_.size() - RPC_LENGTH_SIZE), frame_.data());
+    return std::move(frame_);
+}
+
+RpcReader::RpcReader(std::string_view frame) : data_(frame)
+{
+    Take(RPC_LENGTH_SIZE);
+    type_ = ReadUint8();
+    request_id_ = ReadUint32();
+}
+
+uint8_t RpcReader::GetType() const
+{
+    return type_;
+}
+
+uint32_t RpcReader::GetRequestId() const
+{
+    return request_id_;
+}
+
+std::string_view RpcReader::Take(size_t size)
+{
+    if (data_.size() < size)
+    {
+        throw std::invalid_argument("Truncated RPC frame");
+    }
+    const std::string_view result = data_.substr(0, size);
+    data_.remove_prefix(size);
+    return result;
+}
+
+uint8_t RpcReader::ReadUint8()
+{
+    return static_cast<uint8_t>(Take(1)[0]);
+}
+
+uint32_t RpcReader::ReadUint32()
+{
+    return DecodeUint32(Take(4));
+}
+
+int32_t RpcReader::ReadInt32()
+{
+    return static_cast<int32_t>(ReadUint32());
+}
+
+double RpcReader::ReadDouble()
+{
+    const uint64_t low = ReadUint32();
+    const uint64_t bits = low | (static_cast<uint64_t>(ReadUint32()) << 32);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view RpcReader::ReadString()
+{
+    return Take(ReadUint32());
+}
+
+bool RpcReader::AtEnd() const
+{
+    return data_.empty();
+}
+
+size_t GetCompleteFrameSize(std::string_view buffer)
+{
+    if (buffer.size() < RPC_LENGTH_SIZE)
+    {
+        return 0;
+    }
+    const uint32_t length = DecodeUint32(buffer);
+    if (length > RPC_MAX_FRAME_SIZE)
+    {
+        throw std::invalid_argument("RPC frame is too large");
+    }
+    const size_t frame_size = RPC_LENGTH_SIZE + length;
+    return buffer.size() >= frame_size ? frame_size : 0;
+}
+
+std::string HandleRpcRequest(SearchServer &server, std::string_view frame, const RpcLimits &limits)
+{
+    uint32_t request_id = 0;
+    try
+    {
+        RpcReader reader(frame);
+        request_id = reader.GetRequestId();
+        RpcWriter response(reader.GetType() | RPC_RESPONSE_FLAG, request_id);
+        switch (static_cast<RpcType>(reader.GetType()))
+        {
+        case RpcType::FIND_TOP_DOCUMENTS:
+        {
+            const std::string_view raw_query = reader.ReadString();
+            const DocumentStatus status = ToStatus(reader.ReadUint8());
+            const std::vector<Document> documents = server.FindTopDocuments(raw_query, status);
+            response.WriteUint32(static_cast<uint32_t>(documents.size()));
+            for (const Document &document : documents)
+            {
+                response.WriteInt32(document.id).WriteDouble(document.relevance).WriteInt32(document.rating);
+            }
+            break;
+        }
+        case RpcType::MATCH_DOCUMENT:
+        {
+            const int document_id = reader.ReadInt32();
+            const std::string_view raw_query = reader.ReadString();
+            const auto [words, status] = server.MatchDocument(raw_query, document_id);
+            response.WriteUint8(static_cast<uint8_t>(status)).WriteUint32(static_cast<uint32_t>(words.size()));
+            for (const std::string_view word : words)
+            {
+                response.WriteString(word);
+            }
+            break;
+        }
+        case RpcType::ADD_DOCUMENT:
+        {
+            const int document_id = reader.ReadInt32();
+            if (document_id < 0 || document_id > limits.max_document_id)
+            {
+                throw std::invalid_argument("Document id is out of the allowed range");
+            }
+            const DocumentStatus status = ToStatus(reader.ReadUint8());
+            // без reserve: число рейтингов ещё не проверено, обрезанный кадр кончится исключением
+            const uint32_t rating_count = reader.ReadUint32();
+            std::vector<int> ratings;
+            for (uint32_t i = 0; i < rating_count; ++i)
+            {
+                ratings.push_back(reader.ReadInt32());
+            }
+            server.AddDocument(document_id, std::string(reader.ReadString()), status, ratings);
+            break;
+        }
+        default:
+            throw std::invalid_argument("Unknown RPC request type");
+        }
+        return response.Finish();
+    }
+    catch (const std::exception &e)
+    {
+        return RpcWriter(static_cast<uint8_t>(RpcType::ERROR) | RPC_RESPONSE_FLAG, request_id).WriteString(e.what()).Finish();
+    }
+}
+
+std::vector<std::string> HandleRpcBatch(SearchServer &server, const std::vector<std::string_view> &frames,
+                                        const RpcLimits &limits)
+{
+    std::vector<std::string> responses(frames.size());
+    size_t begin = 0;
+    while (begin < frames.size())
+    {
+        if (IsWriteRequest(frames[begin]))
+        {
+            responses[begin] = HandleRpcRequest(server, frames[begin], limits);
+            ++begin;
+            continue;
+        }
+        size_t end = begin;
+        while (end < frames.size() && !IsWriteRequest(frames[end]))
+        {
+            ++end;
+        }
+        std::transform(std::execution::par, frames.begin() + begin, frames.begin() + end, responses.begin() + begin,
+                       [&server, &limits](std::string_view frame) { return HandleRpcRequest(server, frame, limits); });
+        begin = end;
+    }
+    return responses;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Кадр: [uint32 длина остатка кадра][uint8 тип][uint32 id запроса][данные], числа little-endian,
+// строка - uint32 длина и байты. Клиент может слать запросы, не дожидаясь ответов: ответы на
+// запросы одного соединения приходят в том же порядке и с теми же id
+enum class RpcType : uint8_t
+{
+    // строка запроса, uint8 статус -> uint32 n, n * (int32 id, double relevance, int32 rating)
+    FIND_TOP_DOCUMENTS = 1,
+    // int32 id, строка запроса -> uint8 статус, uint32 n, n строк
+    MATCH_DOCUMENT = 2,
+    // int32 id, uint8 статус, uint32 n, n * int32 рейтинг, строка текста -> пусто
+    ADD_DOCUMENT = 3,
+    // только в ответах: строка с текстом исключения
+    ERROR = 0x7F,
+};
+
+// тип ответа - тип запроса с этим флагом
+const uint8_t RPC_RESPONSE_FLAG = 0x80;
+const size_t RPC_LENGTH_SIZE = 4;
+const size_t RPC_HEADER_SIZE = RPC_LENGTH_SIZE + 1 + 4;
+const uint32_t RPC_MAX_FRAME_SIZE = 16u << 20;
+
+class RpcWriter
+{
+public:
+    RpcWriter(uint8_t type, uint32_t request_id);
+
+    RpcWriter &WriteUint8(uint8_t value);
+    RpcWriter &WriteUint32(uint32_t value);
+    RpcWriter &WriteInt32(int32_t value);
+    RpcWriter &WriteDouble(double value);
+    RpcWriter &WriteString(std::string_view value);
+
+    // проставляет длину и отдаёт кадр целиком
+    std::string Finish();
+
+private:
+    std::string frame_;
+};
+
+// Чтение полного кадра; выход за его границы - std::invalid_argument
+class RpcReader
+{
+public:
+    explicit RpcReader(std::string_view frame);
+
+    uint8_t GetType() const;
+    uint32_t GetRequestId() const;
+
+    uint8_t ReadUint8();
+    uint32_t ReadUint32();
+    int32_t ReadInt32();
+    double ReadDouble();
+    std::string_view ReadString();
+    bool AtEnd() const;
+
+private:
+    std::string_view Take(size_t size);
+
+    std::string_view data_;
+    uint8_t type_ = 0;
+    uint32_t request_id_ = 0;
+};
+
+// Ограничения на запросы из сети, проверяются до обращения к серверу
+struct RpcLimits
+{
+    // ADD_DOCUMENT с id вне [0, max_document_id] получает ответ RpcType::ERROR
+    int max_document_id = std::numeric_limits<int>::max();
+    // Пока неотправленных ответов соединения больше max_pending_output_bytes, сервер не читает
+    // его и не выполняет его кадры; продолжает, когда их останется не больше resume_output_bytes
+    size_t max_pending_output_bytes = 4u << 20;
+    size_t resume_output_bytes = 1u << 20;
+};
+
+// Размер первого кадра в buffer, если он получен целиком, иначе 0.
+// Длина больше RPC_MAX_FRAME_SIZE - std::invalid_argument: соединение стоит закрыть
+size_t GetCompleteFrameSize(std::string_view buffer);
+
+// Ошибки запроса возвращаются ответом RpcType::ERROR, а не исключением
+std::string HandleRpcRequest(SearchServer &server, std::string_view frame, const RpcLimits &limits = {});
+
+// Ответы в порядке кадров. Подряд идущие поиски и сопоставления выполняются параллельно,
+// добавление документа ждёт предыдущие запросы и выполняется раньше следующих
+std::vector<std::string> HandleRpcBatch(SearchServer &server, const std::vector<std::string_view> &frames,
+                                        const RpcLimits &limits = {});
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Плотный аккумулятор релевантности для последовательного ядра: сумма и поколение по слоту документа.
+// Сброс - увеличение текущего поколения, слоты с устаревшим поколением считаются отсутствующими,
+// поэтому ни сброс, ни повторные запросы не трогают кучу, пока не вырастет число слотов.
+// Не потокобезопасен: сервер держит по экземпляру на поток
+class ScoreAccumulator
+{
+public:
+    // готовит аккумулятор к запросу по слотам меньше slot_bound. Экземпляр живёт столько же,
+    // сколько поток, поэтому память, намного превышающая нужную, возвращается
+    void Reset(size_t slot_bound)
+    {
+        if (slot_bound > scores_.size() || slot_bound * SHRINK_FACTOR < scores_.size())
+        {
+            std::vector<double>(slot_bound).swap(scores_);
+            std::vector<uint32_t>(slot_bound, 0).swap(generations_);
+            std::vector<int>().swap(touched_);
+        }
+        if (++generation_ == 0)
+        {
+            std::fill(generations_.begin(), generations_.end(), 0);
+            generation_ = 1;
+        }
+        touched_.clear();
+        size_ = 0;
+    }
+
+    void Add(int slot, double score)
+    {
+        if (generations_[slot] == generation_)
+        {
+            scores_[slot] += score;
+            return;
+        }
+        generations_[slot] = generation_;
+        scores_[slot] = score;
+        touched_.push_back(slot);
+        ++size_;
+    }
+
+    bool Erase(int slot)
+    {
+        if (static_cast<size_t>(slot) >= generations_.size() || generations_[slot] != generation_)
+        {
+            return false;
+        }
+        generations_[slot] = 0;
+        --size_;
+        return true;
+    }
+
+    size_t GetSize() const
+    {
+        return size_;
+    }
+
+    size_t GetCapacity() const
+    {
+        return scores_.capacity();
+    }
+
+    // обходит слоты текущего запроса по возрастанию; callback может удалять их через Erase
+    template <typename Callback>
+    void ForEach(Callback callback)
+    {
+        std::sort(touched_.begin(), touched_.end());
+        touched_.erase(std::unique(touched_.begin(), touched_.end()), touched_.end());
+        for (const int slot : touched_)
+        {
+            if (generations_[slot] == generation_)
+            {
+                callback(slot, scores_[slot]);
+            }
+        }
+    }
+
+private:
+    static const size_t SHRINK_FACTOR = 4;
+
+    std::vector<double> scores_;
+    std::vector<uint32_t> generations_;
+    // слоты в порядке первого попадания; после Erase и повторного Add слот может встретиться дважды
+    std::vector<int> touched_;
+    uint32_t generation_ = 0;
+    size_t size_ = 0;
+};
@@ -0,0 +1,72 @@
+#include "scoring.h"
+
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+double ComputeInverseDocumentFreq(RankingModel model, int document_count, size_t term_document_count)
+{
+    const double term_count = static_cast<double>(term_document_count);
+    if (model == RankingModel::BM25)
+    {
+        // вариант с +1, чтобы слово из большинства документов не давало отрицательный вклад
+        return std::log(1.0 + (document_count - term_count + 0.5) / (term_count + 0.5));
+    }
+    return std::log(document_count / term_count);
+}
+
+TermScorer::TermScorer(const RankingOptions &options, double weight, double average_document_length)
+    : model_(options.model),
+      weight_(weight),
+      saturation_weight_(weight * (options.k1 + 1.0)),
+      length_bias_(options.k1 * (1.0 - options.b)),
+      length_scale_(average_document_length > 0.0 ? options.k1 * options.b / average_document_length : 0.0)
+{
+}
+
+void TermScorer::ScoreBlock(const double *term_freqs, const double *document_lengths, double *scores, size_t count) const
+{
+    size_t i = 0;
+#ifdef __AVX2__
+    if (model_ == RankingModel::TF_IDF)
+    {
+        const __m256d weight = _mm256_set1_pd(weight_);
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm256_storeu_pd(scores + i, _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), weight));
+        }
+    }
+    else
+    {
+        const __m256d saturation_weight = _mm256_set1_pd(saturation_weight_);
+        const __m256d length_bias = _mm256_set1_pd(length_bias_);
+        const __m256d length_scale = _mm256_set1_pd(length_scale_);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m256d length = _mm256_loadu_pd(document_lengths + i);
+            const __m256d occurrences = _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), length);
+            // порядок операций тот же, что в Score, чтобы результаты совпадали побитно
+            const __m256d norm = _mm256_add_pd(_mm256_add_pd(occurrences, length_bias), _mm256_mul_pd(length_scale, length));
+            _mm256_storeu_pd(scores + i, _mm256_div_pd(_mm256_mul_pd(saturation_weight, occurrences), norm));
+        }
+    }
+#endif
+    // без AVX2 - простые циклы без ветвлений, которые компилятор векторизует сам
+    if (model_ == RankingModel::TF_IDF)
+    {
+        for (; i < count; ++i)
+        {
+            scores[i] = term_freqs[i] * weight_;
+        }
+    }
+    else
+    {
+        for (; i < count; ++i)
+        {
+            const double occurrences = term_freqs[i] * document_lengths[i];
+            scores[i] = saturation_weight_ * occurrences / (occurrences + length_bias_ + length_scale_ * document_lengths[i]);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+enum class RankingModel
+{
+    TF_IDF,
+    BM25,
+};
+
+struct RankingOptions
+{
+    RankingModel model = RankingModel::TF_IDF;
+    // параметры BM25: насыщение частоты слова и нормировка по длине документа
+    double k1 = 1.2;
+    double b = 0.75;
+};
+
+double ComputeInverseDocumentFreq(RankingModel model, int document_count, size_t term_document_count);
+
+// Всё, что нужно для оценки постингов одного слова запроса.
+// term_freq - доля слова в документе, как она хранится в индексе
+class TermScorer
+{
+public:
+    TermScorer(const RankingOptions &options, double weight, double average_document_length);
+
+    double GetWeight() const
+    {
+        return weight_;
+    }
+
+    double Score(double term_freq, double document_length) const
+    {
+        if (model_ == RankingModel::TF_IDF)
+        {
+            return term_freq * weight_;
+        }
+        const double count = term_freq * document_length;
+        return saturation_weight_ * count / (count + length_bias_ + length_scale_ * document_length);
+    }
+
+    // scores[i] = Score(term_freqs[i], document_lengths[i]); с AVX2 - по четыре постинга за раз
+    void ScoreBlock(const double *term_freqs, const double *document_lengths, double *scores, size_t count) const;
+
+private:
+    RankingModel model_;
+    double weight_;
+    // BM25: weight * (k1 + 1), k1 * (1 - b) и k1 * b / avgdl
+    double saturation_weight_;
+    double length_bias_;
+    double length_scale_;
+};
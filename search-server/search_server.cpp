@@ -1,5 +1,7 @@
 #include "search_server.h"
 
+#include "corpus_statistics.h"
+
 
 using namespace std;
 
@@ -18,21 +20,20 @@ SearchServer::SearchServer(std::string_view stop_words_text)
 
 
 
-set<int>::const_iterator SearchServer::begin()
+set<int>::const_iterator SearchServer::begin() const
 
 {
     const auto it = index_to_id.begin();
     return it;
 }
-set<int>::const_iterator SearchServer::end()
+set<int>::const_iterator SearchServer::end() const
 
 {
     const auto it = index_to_id.end();
     return it;
 }
 
-const map<string_view, double>&  SearchServer::GetWordFrequencies(const int document_id) const{
-    static const map<string, double> res;
+const pmr::map<string_view, double>&  SearchServer::GetWordFrequencies(const int document_id) const{
 
     auto resultIt = document2words_freqs.find(document_id);
 
@@ -42,25 +43,120 @@ const map<string_view, double>&  SearchServer::GetWordFrequencies(const int docu
     }
     else
     {
-        static const map<string_view, double> res;
+        static const pmr::map<string_view, double> res;
         return res;
     }
 }
 
+IndexStatistics SearchServer::GetIndexStatistics() const
+{
+    IndexStatistics result = index_statistics_;
+    result.document_count = GetDocumentCount();
+    result.dictionary_size = word_to_document_freqs_.size();
+    result.dictionary_bytes = memory_->dictionary.GetStats().live_bytes;
+    result.posting_bytes = memory_->postings.GetStats().live_bytes;
+    result.forward_index_bytes = memory_->forward_index.GetStats().live_bytes;
+    result.position_bytes = index_statistics_.token_count * sizeof(std::string_view);
+    result.stop_word_bytes = stop_words_.GetMemoryUsage();
+    result.column_bytes = id_by_slot_.capacity() * sizeof(int) + status_by_slot_.capacity() * sizeof(DocumentStatus)
+                          + rating_by_slot_.capacity() * sizeof(int) + length_by_slot_.capacity() * sizeof(int)
+                          + free_slots_.capacity() * sizeof(int);
+    return result;
+}
+
+IndexMemoryStats SearchServer::GetMemoryStats() const
+{
+    IndexMemoryStats result;
+    result.dictionary = memory_->dictionary.GetStats();
+    result.postings = memory_->postings.GetStats();
+    result.forward_index = memory_->forward_index.GetStats();
+    // арены сами отдают память целиком, занятое и взятое у системы для них совпадает
+    const CountingMemoryResource &query_arenas = memory_->query_arenas;
+    result.query_arenas.live_bytes = result.query_arenas.reserved_bytes = query_arenas.GetBytesInUse();
+    result.query_arenas.peak_live_bytes = result.query_arenas.peak_reserved_bytes = query_arenas.GetPeakBytesInUse();
+    result.query_arenas.allocation_count = query_arenas.GetAllocationCount();
+    return result;
+}
+
 std::vector<Document>  SearchServer::FindTopDocuments( const std::string_view raw_query, DocumentStatus status_seek ) const{
-    return SearchServer::FindTopDocuments( std::execution::seq ,raw_query, [status_seek]([[maybe_unused]] int document_id, DocumentStatus status, [[maybe_unused]] int rating)
-    { return status == status_seek; });
+    return SearchServer::FindTopDocuments( std::execution::seq ,raw_query, StatusFilter{status_seek});
 }
 std::vector<Document> SearchServer::FindTopDocuments( const std::string_view raw_query) const{
     return SearchServer::FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
+std::vector<Document> SearchServer::FindTopDocumentsPage(const std::string_view raw_query, size_t page_index,
+                                                         size_t page_size, DocumentStatus status_seek) const
+{
+    return FindTopDocumentsPage(raw_query, page_index, page_size,
+                                StatusFilter{status_seek});
+}
+
+SearchResult SearchServer::FindTopDocumentsUntil(const QueryDeadline &deadline, const std::string_view raw_query,
+                                                 DocumentStatus status_seek) const
+{
+    return FindTopDocumentsUntil(deadline, raw_query,
+                                 StatusFilter{status_seek});
+}
+
+SearchResult SearchServer::FindTopDocumentsWithin(const QueryBudget &budget, const std::string_view raw_query,
+                                                  DocumentStatus status_seek) const
+{
+    return FindTopDocumentsWithin(budget, raw_query,
+                                  StatusFilter{status_seek});
+}
+
+ProfiledSearchResult SearchServer::FindTopDocumentsWithProfile(const std::string_view raw_query,
+                                                               DocumentStatus status_seek) const
+{
+    return FindTopDocumentsWithProfile(raw_query,
+                                       StatusFilter{status_seek});
+}
+
+std::future<SearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, QueryDeadline deadline,
+                                                              DocumentStatus status_seek) const
+{
+    return FindTopDocumentsAsync(std::move(raw_query), std::move(deadline),
+                                 StatusFilter{status_seek});
+}
+
 
 
 
 void SearchServer::AddDocument(int document_id, const std::string &document,
                                               DocumentStatus status, const std::vector<int> &ratings)
 {
+    AddDocument(TokenizeDocument(document_id, document, status, ratings));
+}
+
+TokenizedDocument SearchServer::TokenizeDocument(int document_id, std::string text, DocumentStatus status,
+                                                 std::vector<int> ratings) const
+{
+    if (!IsValidWord(text))
+    {
+        throw std::invalid_argument("document containse resticted symbols");
+    }
+    if (analyzer_.IsEnabled())
+    {
+        // сервер хранит нормализованный текст, слова индекса ссылаются на него
+        text = analyzer_.NormalizeText(text);
+    }
+    TokenizedDocument document{document_id, status, std::move(ratings), std::move(text), {}};
+    const std::vector<std::string_view> words = SplitIntoWords(document.text);
+    document.words.reserve(words.size());
+    for (const std::string_view word : words)
+    {
+        document.words.emplace_back(static_cast<uint32_t>(word.data() - document.text.data()),
+                                    static_cast<uint32_t>(word.size()));
+    }
+    return document;
+}
+
+void SearchServer::AddDocument(TokenizedDocument document)
+{
+    METRIC_TIMER(MetricPhase::ADD_DOCUMENT);
+    const int document_id = document.id;
+    const DocumentStatus status = document.status;
     if (document_id < 0)
     {
         throw std::invalid_argument("document_id < 0");
@@ -69,64 +165,357 @@ void SearchServer::AddDocument(int document_id, const std::string &document,
     {
         throw std::invalid_argument("document_id already exists");
     }
-    if (!IsValidWord(document))
+
+    // колонки растут до того, как тронут индекс: если выделение памяти бросит, сервер не изменится
+    const int slot = free_slots_.empty() ? static_cast<int>(id_by_slot_.size()) : free_slots_.back();
+    if (static_cast<size_t>(slot) == id_by_slot_.size())
     {
-        throw std::invalid_argument("document containse resticted symbols");
+        status_by_slot_.resize(slot + 1, DocumentStatus::REMOVED);
+        rating_by_slot_.resize(slot + 1);
+        length_by_slot_.resize(slot + 1);
+        // удаление кладёт слот сюда и не должно выделять память
+        free_slots_.reserve(slot + 1);
+        id_by_slot_.resize(slot + 1);
     }
 
-    documents_texts.push_back(document);
+    if (has_impact_index_)
+    {
+        impact_postings_.clear();
+        has_impact_index_ = false;
+        index_statistics_.impact_index_bytes = 0;
+    }
+    documents_texts.push_back(std::move(document.text));
+    index_statistics_.document_text_bytes += documents_texts.back().capacity();
 
-    const std::vector<std::string_view> words = SplitIntoWordsNoStop(documents_texts.back());
-    const double inv_word_count = 1.0 / words.size();
+    // смещения переносятся на строку, которая теперь принадлежит серверу
+    const std::string_view text = documents_texts.back();
+    std::vector<std::string_view> words;
+    words.reserve(document.words.size());
+    for (const auto &[offset, size] : document.words)
+    {
+        words.push_back(text.substr(offset, size));
+    }
+    const int length = static_cast<int>(std::count_if(words.begin(), words.end(),
+                                                      [this](std::string_view word) { return !IsStopWord(word); }));
+    // term_freq стоп-слов тоже считается от числа остальных слов: так он не зависит от того,
+    // станет ли слово потом обычным
+    const double inv_word_count = 1.0 / std::max(length, 1);
     for (const std::string_view word : words)
     {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
+        const auto [it, inserted] = word_to_document_freqs_.try_emplace(word, memory_->postings.GetResource());
+        if (inserted)
+        {
+            it->second.is_stop_word = IsStopWord(word);
+        }
+        const auto [posting, is_new_posting] = it->second.For(status).try_emplace(document_id, Posting{0.0, slot});
+        posting->second.term_freq += inv_word_count;
+        if (is_new_posting)
+        {
+            index_statistics_.AddPosting(it->second.GetDocumentCount());
+        }
         document2words_freqs[document_id][word] += inv_word_count;
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    index_statistics_.token_count += words.size();
+    document_words_.emplace(document_id, std::move(words));
+    const int rating = ComputeAverageRating(document.ratings);
+    documents_.emplace(document_id, DocumentData{rating, status, slot});
     index_to_id.insert(document_id);
+    if (!free_slots_.empty())
+    {
+        free_slots_.pop_back();
+    }
+    id_by_slot_[slot] = document_id;
+    status_by_slot_[slot] = status;
+    rating_by_slot_[slot] = rating;
+    length_by_slot_[slot] = length;
+    total_document_length_ += length;
+    METRIC_INCREMENT(MetricCounter::DOCUMENTS_ADDED, 1);
 }
 
 
-void SearchServer::RemoveDocument(execution::parallel_policy policy, int document_id)
+// постинги одного документа - по одному на слово, разбивать их по потокам дороже, чем удалить
+void SearchServer::RemoveDocument(execution::parallel_policy, int document_id)
+{
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocument(execution::sequenced_policy, int document_id)
 {
+    METRIC_TIMER(MetricPhase::REMOVE_DOCUMENT);
     if( document2words_freqs.count(document_id) == 0)
         return;
 
-    std::map<std::string_view, double> words_by_id = GetWordFrequencies(document_id);
-     vector< std::string_view >  wordsDel(words_by_id.size());
-
-    std::transform(std::execution::par,words_by_id.begin(), words_by_id.end(),
-                   wordsDel.begin(), // write to the same location
-                   [](  auto   x) { return   x.first; });
+    const DocumentStatus status = MarkRemoved(document_id);
+    for (auto& [word, freq] : document2words_freqs.at(document_id)) {
+        TermPostings &postings = word_to_document_freqs_.at(word);
+        postings.For(status).erase(document_id);
+        index_statistics_.RemovePosting(postings.GetDocumentCount());
+    }
+    document2words_freqs.erase(document_id);
+    METRIC_INCREMENT(MetricCounter::DOCUMENTS_REMOVED, 1);
+}
 
-    std::for_each(std::execution::par,wordsDel.begin(),wordsDel.end() ,[&document_id, this](string_view word){ word_to_document_freqs_.at(word).erase(document_id);} );
+void SearchServer::RemoveDocument(int document_id){
+    RemoveDocument(std::execution::seq,  document_id);
+}
 
-    document2words_freqs.erase(document_id);
-    documents_.erase(document_id);
-    index_to_id.erase( document_id);
+void SearchServer::RemoveDocuments(const std::vector<int> &document_ids)
+{
+    METRIC_TIMER(MetricPhase::REMOVE_DOCUMENT);
+    std::vector<std::pair<int, DocumentStatus>> removed;
+    removed.reserve(document_ids.size());
+    for (const int document_id : document_ids)
+    {
+        // повторный id уже снят с учёта и сюда не попадает
+        if (documents_.count(document_id) > 0)
+        {
+            removed.emplace_back(document_id, MarkRemoved(document_id));
+        }
+    }
+    if (removed.empty())
+    {
+        return;
+    }
+    CompactPostings(removed);
+    for (const auto &[document_id, _] : removed)
+    {
+        document2words_freqs.erase(document_id);
+    }
+    METRIC_INCREMENT(MetricCounter::DOCUMENTS_REMOVED, removed.size());
+}
 
+DocumentStatus SearchServer::MarkRemoved(int document_id)
+{
+    const auto it = documents_.find(document_id);
+    const DocumentStatus status = it->second.status;
+    const auto words_it = document_words_.find(document_id);
+    index_statistics_.token_count -= words_it->second.size();
+    document_words_.erase(words_it);
+    const int slot = it->second.slot;
+    total_document_length_ -= length_by_slot_[slot];
+    status_by_slot_[slot] = DocumentStatus::REMOVED;
+    free_slots_.push_back(slot);
+    documents_.erase(it);
+    index_to_id.erase(document_id);
+    return status;
 }
 
+void SearchServer::CompactPostings(const std::vector<std::pair<int, DocumentStatus>> &removed)
+{
+    // пары (слово, документ) всех удаляемых документов, сгруппированные по слову: каждый список
+    // постингов меняет ровно одна задача, а общий словарь только читается
+    struct RemovedPosting
+    {
+        TermPostings *postings;
+        int document_id;
+        DocumentStatus status;
+    };
+    std::vector<RemovedPosting> entries;
+    for (const auto &[document_id, status] : removed)
+    {
+        for (const auto &[word, _] : document2words_freqs.at(document_id))
+        {
+            entries.push_back({&word_to_document_freqs_.find(word)->second, document_id, status});
+        }
+    }
+    std::sort(std::execution::par, entries.begin(), entries.end(),
+              [](const RemovedPosting &lhs, const RemovedPosting &rhs)
+              { return std::tie(lhs.postings, lhs.document_id) < std::tie(rhs.postings, rhs.document_id); });
+
+    std::vector<size_t> group_begins;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (i == 0 || entries[i].postings != entries[i - 1].postings)
+        {
+            group_begins.push_back(i);
+        }
+    }
+    group_begins.push_back(entries.size());
 
+    // длины списков до чистки, статистика обновляется после
+    std::vector<size_t> old_lengths(group_begins.size() - 1);
+    std::vector<size_t> group_indexes(old_lengths.size());
+    std::iota(group_indexes.begin(), group_indexes.end(), 0);
+    std::for_each(std::execution::par, group_indexes.begin(), group_indexes.end(), [&](size_t group)
+    {
+        TermPostings &postings = *entries[group_begins[group]].postings;
+        old_lengths[group] = postings.GetDocumentCount();
+        for (size_t i = group_begins[group]; i < group_begins[group + 1]; ++i)
+        {
+            postings.For(entries[i].status).erase(entries[i].document_id);
+        }
+    });
+    for (size_t group = 0; group < old_lengths.size(); ++group)
+    {
+        index_statistics_.RemovePostings(old_lengths[group],
+                                         entries[group_begins[group]].postings->GetDocumentCount());
+    }
+}
 
-void SearchServer::RemoveDocument(execution::sequenced_policy policy, int document_id)
+void SearchServer::SetDocumentStatus(int document_id, DocumentStatus status)
 {
-    if( document2words_freqs.count(document_id) == 0)
+    DocumentData &data = documents_.at(document_id);
+    if (data.status == status)
+    {
         return;
+    }
+    for (const auto &[word, _] : document2words_freqs.at(document_id))
+    {
+        TermPostings &postings = word_to_document_freqs_.at(word);
+        postings.For(status).insert(postings.For(data.status).extract(document_id));
+    }
+    data.status = status;
+    status_by_slot_[data.slot] = status;
+}
 
-    for (auto& [word, freq] : document2words_freqs.at(document_id)) {
-        word_to_document_freqs_.at(word).erase(document_id);
+bool SearchServer::ContainsDocument(const TermPostings &postings, int document_id) const
+{
+    const auto it = documents_.find(document_id);
+    return it != documents_.end() && postings.For(it->second.status).count(document_id) > 0;
+}
+
+// В фразах запроса нет стоп-слов, поэтому стоп-слова документа между её словами пропускаются
+bool SearchServer::ContainsPhrase(int document_id, const std::vector<std::string_view> &phrase) const
+{
+    if (phrase.empty())
+    {
+        return true;
     }
+    const std::vector<std::string_view> &words = document_words_.at(document_id);
+    for (size_t begin = 0; begin < words.size(); ++begin)
+    {
+        if (words[begin] != phrase[0])
+        {
+            continue;
+        }
+        size_t matched = 1;
+        for (size_t i = begin + 1; i < words.size() && matched < phrase.size(); ++i)
+        {
+            if (words[i] == phrase[matched])
+            {
+                ++matched;
+            }
+            else if (!IsStopWord(words[i]))
+            {
+                break;
+            }
+        }
+        if (matched == phrase.size())
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-    document2words_freqs.erase(document_id);
-    documents_.erase(document_id);
-    index_to_id.erase( document_id);
+bool SearchServer::MatchesPhrases(const Query &query, int document_id) const
+{
+    return std::all_of(query.phrases.begin(), query.phrases.end(),
+                       [this, document_id](const auto &phrase) { return ContainsPhrase(document_id, phrase); })
+           && std::none_of(query.minus_phrases.begin(), query.minus_phrases.end(),
+                           [this, document_id](const auto &phrase) { return ContainsPhrase(document_id, phrase); });
+}
 
+bool SearchServer::MatchesConstraints(const Query &query, int document_id) const
+{
+    for (const auto &group : query.required_groups)
+    {
+        const bool has_any = std::any_of(group.begin(), group.end(), [this, document_id](std::string_view word)
+        {
+            const auto it = word_to_document_freqs_.find(word);
+            return it != word_to_document_freqs_.end() && ContainsDocument(it->second, document_id);
+        });
+        if (!has_any)
+        {
+            return false;
+        }
+    }
+    return MatchesPhrases(query, document_id);
 }
 
-void SearchServer::RemoveDocument(int document_id){
-    RemoveDocument(std::execution::seq,  document_id);
+// Leapfrog join: кандидат двигается к наименьшему id не меньше текущего, который есть в очередной
+// группе; когда все группы подряд согласны, кандидат попадает в результат. Постинги раздела
+// отсортированы по id, поэтому каждый сдвиг - lower_bound, а не проход по списку
+std::vector<int> SearchServer::IntersectRequiredGroups(const Query &query, DocumentStatus status) const
+{
+    std::vector<std::vector<const Postings *>> groups;
+    for (const auto &group : query.required_groups)
+    {
+        std::vector<const Postings *> postings;
+        for (const std::string_view word : group)
+        {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it != word_to_document_freqs_.end() && !it->second.For(status).empty())
+            {
+                postings.push_back(&it->second.For(status));
+            }
+        }
+        if (postings.empty())
+        {
+            return {};
+        }
+        groups.push_back(std::move(postings));
+    }
+
+    const auto group_size = [](const std::vector<const Postings *> &group)
+    {
+        size_t size = 0;
+        for (const Postings *postings : group)
+        {
+            size += postings->size();
+        }
+        return size;
+    };
+    // короткие группы первыми: они дают самые далёкие сдвиги
+    std::sort(groups.begin(), groups.end(), [&group_size](const auto &lhs, const auto &rhs)
+              { return group_size(lhs) < group_size(rhs); });
+
+    // пустой результат - в группе нет id не меньше target; любое значение int - допустимый id
+    const auto seek = [](const std::vector<const Postings *> &group, int target)
+    {
+        std::optional<int> next;
+        for (const Postings *postings : group)
+        {
+            const auto it = postings->lower_bound(target);
+            if (it != postings->end() && (!next || it->first < *next))
+            {
+                next = it->first;
+            }
+        }
+        return next;
+    };
+
+    std::vector<int> result;
+    std::optional<int> candidate = seek(groups[0], 0);
+    size_t agreed = 1;
+    size_t group_index = 1 % groups.size();
+    while (candidate)
+    {
+        if (agreed == groups.size())
+        {
+            result.push_back(*candidate);
+            if (*candidate == std::numeric_limits<int>::max())
+            {
+                break;
+            }
+            candidate = seek(groups[0], *candidate + 1);
+            agreed = 1;
+            group_index = 1 % groups.size();
+            continue;
+        }
+        const std::optional<int> next = seek(groups[group_index], *candidate);
+        if (next == candidate)
+        {
+            ++agreed;
+        }
+        else
+        {
+            candidate = next;
+            agreed = 1;
+        }
+        group_index = (group_index + 1) % groups.size();
+    }
+    return result;
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus>
@@ -140,18 +529,22 @@ SearchServer::MatchDocument(std::execution::sequenced_policy, const std::string_
         if (it == word_to_document_freqs_.end()) {
             continue;
         }
-        if (it->second.count(document_id)) {
+        if (ContainsDocument(it->second, document_id)) {
             return {matched_words, documents_.at(document_id).status};
         }
     }
+    if (!query.IsPlain() && !MatchesConstraints(query, document_id)) {
+        return {matched_words, documents_.at(document_id).status};
+    }
 
     for (std::string_view word: query.plus_words) {
         auto it = word_to_document_freqs_.find(word);
         if (it == word_to_document_freqs_.end()) {
             continue;
         }
-        if (it->second.count(document_id)) {
-            matched_words.push_back(word);
+        if (ContainsDocument(it->second, document_id)) {
+            // ключ индекса живёт дольше, чем строка запроса
+            matched_words.push_back(it->first);
         }
     }
 
@@ -167,41 +560,27 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     if (!documents_.count(document_id)) {
         throw out_of_range("Недействительный id документа"s);
     }
-    vector<string_view> minusWords ;
-    vector<string_view> plusWords ;
-    auto words = SplitIntoWords(raw_query);
-    for_each(execution::par,words.begin(),words.end(), [&](auto word){
-        const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop)
-        {
-            if (query_word.is_minus)
-            {
-                minusWords.push_back(query_word.data);
-            }
-            else
-            {
-                plusWords.push_back(query_word.data);
-            }
-    } });
-
-
+    const Query query = ParseQuery(raw_query);
     std::vector<std::string_view> matched_words;
 
 
-    if (std::any_of( execution::par,minusWords.begin(), minusWords.end(),[document_id, this](string_view word){ return word_to_document_freqs_.count(word) > 0 && word_to_document_freqs_.at(word).count(document_id) > 0; })){
+    if (std::any_of( execution::par,query.minus_words.begin(), query.minus_words.end(),[document_id, this](string_view word){ return word_to_document_freqs_.count(word) > 0 && ContainsDocument(word_to_document_freqs_.at(word), document_id); })){
         return {matched_words, documents_.at(document_id).status};
 
     }
-    matched_words.resize(plusWords.size());
+    if (!query.IsPlain() && !MatchesConstraints(query, document_id)) {
+        return {matched_words, documents_.at(document_id).status};
+    }
+    matched_words.resize(query.plus_words.size());
 
 
-    auto last_copied = std::copy_if( execution::par,plusWords.begin(), plusWords.end(),matched_words.begin(), [document_id, this](string_view word)
-    {return word_to_document_freqs_.count(word) > 0 && word_to_document_freqs_.at(word).count(document_id) > 0 ;});
+    auto last_copied = std::copy_if( execution::par,query.plus_words.begin(), query.plus_words.end(),matched_words.begin(), [document_id, this](string_view word)
+    {return word_to_document_freqs_.count(word) > 0 && ContainsDocument(word_to_document_freqs_.at(word), document_id);});
 
+    // plus_words уже отсортированы и уникальны
     matched_words.erase(last_copied, matched_words.end());
-    std::sort(execution::par, matched_words.begin(), matched_words.end());
-    auto last = std::unique( matched_words.begin(), matched_words.end());
-    matched_words.erase(last, matched_words.end());
+    std::transform(execution::par, matched_words.begin(), matched_words.end(), matched_words.begin(),
+                   [this](string_view word) { return word_to_document_freqs_.find(word)->first; });
 
     return {matched_words, documents_.at(document_id).status};
 
@@ -227,7 +606,103 @@ bool SearchServer::IsValidWord(const std::string_view word) const
 
 bool SearchServer::IsStopWord(const std::string_view word) const
 {
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
+}
+
+void SearchServer::SetStopWords(const std::string &stop_words_text)
+{
+    SetStopWords(SplitIntoWords(std::string_view(stop_words_text)));
+}
+
+void SearchServer::SetStopWords(std::string_view stop_words_text)
+{
+    SetStopWords(SplitIntoWords(stop_words_text));
+}
+
+void SearchServer::ApplyStopWords(std::vector<std::string> stop_words)
+{
+    if (analyzer_.IsEnabled())
+    {
+        // после нормализации стоп-слово может распасться на несколько слов
+        std::vector<std::string> normalized_words;
+        for (const std::string &word : stop_words)
+        {
+            const std::string normalized = analyzer_.NormalizeText(word);
+            for (const std::string_view normalized_word : SplitIntoWords(normalized))
+            {
+                normalized_words.emplace_back(normalized_word);
+            }
+        }
+        stop_words_ = StopWordSet(std::move(normalized_words));
+    }
+    else
+    {
+        stop_words_ = StopWordSet(stop_words);
+    }
+    raw_stop_words_ = std::move(stop_words);
+    for (auto &[word, term_postings] : word_to_document_freqs_)
+    {
+        term_postings.is_stop_word = stop_words_.Contains(word);
+    }
+    if (has_impact_index_)
+    {
+        impact_postings_.clear();
+        has_impact_index_ = false;
+        index_statistics_.impact_index_bytes = 0;
+    }
+}
+
+void SearchServer::SetAnalyzerOptions(const AnalyzerOptions &options)
+{
+    if (GetDocumentCount() > 0)
+    {
+        throw std::logic_error("Analyzer options must be set before documents are added");
+    }
+    analyzer_ = Analyzer(options);
+    // нормализуются исходные слова: результат прошлого анализатора мог потерять их форму
+    ApplyStopWords(raw_stop_words_);
+}
+
+const AnalyzerOptions &SearchServer::GetAnalyzerOptions() const
+{
+    return analyzer_.GetOptions();
+}
+
+std::vector<TermVolume> SearchServer::GetStopWordVolumes() const
+{
+    std::vector<TermVolume> result;
+    for (const std::string &word : stop_words_.GetWords())
+    {
+        const auto it = word_to_document_freqs_.find(word);
+        result.push_back({word, it == word_to_document_freqs_.end() ? 0 : it->second.GetDocumentCount(), true});
+    }
+    std::stable_sort(result.begin(), result.end(), [](const TermVolume &lhs, const TermVolume &rhs)
+                     { return lhs.document_count > rhs.document_count; });
+    return result;
+}
+
+std::vector<TermVolume> SearchServer::GetHeaviestTerms(size_t count) const
+{
+    std::vector<std::pair<size_t, std::string_view>> terms;
+    for (const auto &[word, term_postings] : word_to_document_freqs_)
+    {
+        if (!term_postings.is_stop_word && term_postings.GetDocumentCount() > 0)
+        {
+            terms.emplace_back(term_postings.GetDocumentCount(), word);
+        }
+    }
+    const auto by_volume = [](const auto &lhs, const auto &rhs)
+    { return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second); };
+    const size_t top_count = std::min(count, terms.size());
+    std::partial_sort(terms.begin(), terms.begin() + top_count, terms.end(), by_volume);
+
+    std::vector<TermVolume> result;
+    result.reserve(top_count);
+    for (size_t i = 0; i < top_count; ++i)
+    {
+        result.push_back({std::string(terms[i].second), terms[i].first, false});
+    }
+    return result;
 }
 
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const
@@ -341,16 +816,317 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
 
 
 
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
+// Слова фразы или группы: операторы внутри не допускаются, стоп-слова выбрасываются,
+// а ContainsPhrase пропускает их в документе
+std::vector<std::string_view> SearchServer::ParseWordSequence(std::string_view text) const
+{
+    std::vector<std::string_view> words;
+    for (const std::string_view word : SplitIntoWords(text))
+    {
+        if (word[0] == '+' || word[0] == '-')
+        {
+            throw std::invalid_argument("Operator inside phrase or group");
+        }
+        const QueryWord query_word = ParseQueryWord(word);
+        if (!query_word.is_stop)
+        {
+            words.push_back(query_word.data);
+        }
+    }
+    return words;
+}
+
+std::vector<std::string_view> SearchServer::ExpandPrefix(std::string_view prefix, size_t max_count) const
+{
+    if (corpus_statistics_ != nullptr)
+    {
+        return ExpandPrefix(corpus_statistics_->document_freqs, [this](const auto &entry)
+                            { return IsStopWord(entry.first) ? 0 : static_cast<size_t>(entry.second); },
+                            prefix, max_count);
+    }
+    return ExpandPrefix(word_to_document_freqs_, [](const auto &entry)
+                        { return entry.second.is_stop_word ? 0 : entry.second.GetDocumentCount(); },
+                        prefix, max_count);
+}
+
+std::vector<std::pair<std::string_view, int>> SearchServer::FindSimilarTerms(std::string_view word, int max_distance,
+                                                                             size_t max_count) const
+{
+    if (corpus_statistics_ != nullptr)
+    {
+        return FindSimilarTerms(corpus_statistics_->document_freqs, [this](const auto &entry)
+                                { return IsStopWord(entry.first) ? 0 : static_cast<size_t>(entry.second); },
+                                word, max_distance, max_count);
+    }
+    return FindSimilarTerms(word_to_document_freqs_, [](const auto &entry)
+                            { return entry.second.is_stop_word ? 0 : entry.second.GetDocumentCount(); },
+                            word, max_distance, max_count);
+}
+
+bool SearchServer::HasDictionaryWord(std::string_view word) const
+{
+    if (corpus_statistics_ != nullptr)
+    {
+        return corpus_statistics_->GetDocumentFreq(word) > 0;
+    }
+    return word_to_document_freqs_.count(word) > 0;
+}
+
+// Слова словаря с заданным префиксом идут в нём подряд. Если их больше max_count,
+// остаются самые частые; результат отсортирован, как и ключи словаря
+template <typename Dictionary, typename DocumentCount>
+std::vector<std::string_view> SearchServer::ExpandPrefix(const Dictionary &dictionary, DocumentCount document_count,
+                                                         std::string_view prefix, size_t max_count)
+{
+    std::vector<std::pair<size_t, std::string_view>> terms;
+    for (auto it = dictionary.lower_bound(prefix);
+         it != dictionary.end() && std::string_view(it->first).substr(0, prefix.size()) == prefix; ++it)
+    {
+        if (const size_t count = document_count(*it); count > 0)
+        {
+            terms.emplace_back(count, it->first);
+        }
+    }
+    if (terms.size() > max_count)
+    {
+        std::nth_element(terms.begin(), terms.begin() + max_count, terms.end(),
+                         [](const auto &lhs, const auto &rhs) { return lhs.first > rhs.first; });
+        terms.resize(max_count);
+    }
+
+    std::vector<std::string_view> result;
+    result.reserve(terms.size());
+    for (const auto &[_, word] : terms)
+    {
+        result.push_back(word);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Обход словаря как неявного префиксного дерева: строка DP расстояния Левенштейна для префикса
+// термина переиспользуется следующим термином с тем же префиксом. Если все значения строки
+// больше max_distance, ни одно слово с этим префиксом не подходит, и обход перескакивает
+// через них lower_bound-ом - это то же пересечение автомата Левенштейна со словарём
+template <typename Dictionary, typename DocumentCount>
+std::vector<std::pair<std::string_view, int>> SearchServer::FindSimilarTerms(const Dictionary &dictionary,
+                                                                             DocumentCount document_count,
+                                                                             std::string_view word, int max_distance,
+                                                                             size_t max_count)
+{
+    const size_t width = word.size() + 1;
+    // строка depth - расстояния от первых depth символов термина до префиксов word
+    std::vector<int> rows(width);
+    std::iota(rows.begin(), rows.end(), 0);
+    std::string_view previous;
+    std::vector<std::tuple<int, size_t, std::string_view>> matches;
+
+    auto it = dictionary.begin();
+    while (it != dictionary.end())
+    {
+        const std::string_view term = it->first;
+        size_t depth = 0;
+        const size_t computed = rows.size() / width - 1;
+        while (depth < computed && depth < term.size() && term[depth] == previous[depth])
+        {
+            ++depth;
+        }
+        rows.resize((depth + 1) * width);
+        previous = term;
+
+        bool pruned = false;
+        for (; depth < term.size(); ++depth)
+        {
+            const size_t prev = depth * width;
+            rows.resize(rows.size() + width);
+            const size_t row = prev + width;
+            rows[row] = static_cast<int>(depth) + 1;
+            int row_min = rows[row];
+            for (size_t j = 1; j < width; ++j)
+            {
+                rows[row + j] = std::min({rows[prev + j] + 1, rows[row + j - 1] + 1,
+                                          rows[prev + j - 1] + (word[j - 1] == term[depth] ? 0 : 1)});
+                row_min = std::min(row_min, rows[row + j]);
+            }
+            if (row_min > max_distance)
+            {
+                pruned = true;
+                break;
+            }
+        }
+
+        if (!pruned)
+        {
+            const int distance = rows.back();
+            if (const size_t count = document_count(*it); distance <= max_distance && count > 0)
+            {
+                matches.emplace_back(distance, count, term);
+            }
+            ++it;
+            continue;
+        }
+
+        // следующий возможный префикс после term[0, depth]
+        std::string next_prefix(term.substr(0, depth + 1));
+        // ключи сравниваются как unsigned char
+        while (!next_prefix.empty() && static_cast<unsigned char>(next_prefix.back()) == 0xFF)
+        {
+            next_prefix.pop_back();
+        }
+        if (next_prefix.empty())
+        {
+            break;
+        }
+        next_prefix.back() = static_cast<char>(static_cast<unsigned char>(next_prefix.back()) + 1);
+        it = dictionary.lower_bound(next_prefix);
+    }
+
+    // сначала ближайшие, среди равных - самые частые
+    std::sort(matches.begin(), matches.end(), [](const auto &lhs, const auto &rhs)
+              { return std::get<0>(lhs) < std::get<0>(rhs)
+                       || (std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) > std::get<1>(rhs)); });
+    if (matches.size() > max_count)
+    {
+        matches.resize(max_count);
+    }
+    std::vector<std::pair<std::string_view, int>> result;
+    for (const auto &[distance, _, term] : matches)
+    {
+        result.emplace_back(term, distance);
+    }
+    return result;
+}
+
+// Синтаксис: слово, -слово, +слово, префикс*, "фраза", -"фраза", (группа), +(группа), -(группа).
+// + и - перед кавычкой или скобкой относятся ко всей фразе или группе
+SearchServer::Query SearchServer::ParseQuery(const std::string_view raw_text) const
 {
     Query query;
+    std::string_view text = raw_text;
+    if (analyzer_.IsEnabled())
+    {
+        // анализатор превратил бы недопустимые символы в разделители
+        if (!IsValidWord(raw_text))
+        {
+            throw std::invalid_argument("Word contains restricted symbols");
+        }
+        query.normalized_text = std::make_shared<const std::string>(analyzer_.NormalizeQuery(raw_text));
+        text = *query.normalized_text;
+    }
     std::set<std::string_view> minus_words_set;
     std::set<std::string_view> plus_words_set;
+    std::set<std::string_view> required_words_set;
+    std::vector<std::string_view> fuzzy_words;
 
-    for (std::string_view word : SplitIntoWords(text))
+    size_t pos = 0;
+    while ((pos = text.find_first_not_of(' ', pos)) != text.npos)
     {
+        char modifier = 0;
+        if ((text[pos] == '+' || text[pos] == '-') && pos + 1 < text.size()
+            && (text[pos + 1] == '"' || text[pos + 1] == '('))
+        {
+            modifier = text[pos++];
+        }
 
+        const bool is_phrase = text[pos] == '"';
+        const size_t close = is_phrase || text[pos] == '(' ? text.find(is_phrase ? '"' : ')', pos + 1) : text.npos;
+        if (close == text.npos && modifier != 0)
+        {
+            // незакрытая кавычка или скобка - часть обычного слова, как до появления операторов
+            --pos;
+        }
+        if (close != text.npos)
+        {
+            std::vector<std::string_view> words = ParseWordSequence(text.substr(pos + 1, close - pos - 1));
+            pos = close + 1;
+            if (words.empty())
+            {
+                continue;
+            }
+            if (modifier == '-')
+            {
+                if (is_phrase && words.size() > 1)
+                {
+                    query.minus_phrases.push_back(std::move(words));
+                }
+                else
+                {
+                    minus_words_set.insert(words.begin(), words.end());
+                }
+                continue;
+            }
+            plus_words_set.insert(words.begin(), words.end());
+            if (is_phrase)
+            {
+                required_words_set.insert(words.begin(), words.end());
+                if (words.size() > 1)
+                {
+                    query.phrases.push_back(std::move(words));
+                }
+            }
+            else if (modifier == '+')
+            {
+                std::sort(words.begin(), words.end());
+                words.erase(std::unique(words.begin(), words.end()), words.end());
+                if (words.size() == 1)
+                {
+                    required_words_set.insert(words[0]);
+                }
+                else
+                {
+                    query.required_groups.push_back(std::move(words));
+                }
+            }
+            continue;
+        }
+
+        const size_t end = std::min(text.find(' ', pos), text.size());
+        std::string_view word = text.substr(pos, end - pos);
+        pos = end;
+        bool is_required = false;
+        if (word[0] == '+')
+        {
+            word.remove_prefix(1);
+            if (word.empty())
+            {
+                throw std::invalid_argument("Search word consists of one plus");
+            }
+            if (word[0] == '+' || word[0] == '-')
+            {
+                throw std::invalid_argument("Two operators before word");
+            }
+            is_required = true;
+        }
         const QueryWord query_word = ParseQueryWord(word);
+        if (query_word.data.size() > 1 && query_word.data.back() == '*')
+        {
+            const std::string_view prefix = query_word.data.substr(0, query_word.data.size() - 1);
+            if (query_word.is_minus)
+            {
+                const std::vector<std::string_view> terms = ExpandPrefix(prefix, std::numeric_limits<size_t>::max());
+                minus_words_set.insert(terms.begin(), terms.end());
+                continue;
+            }
+            std::vector<std::string_view> terms = ExpandPrefix(prefix, expansion_options_.max_prefix_expansions);
+            plus_words_set.insert(terms.begin(), terms.end());
+            if (is_required)
+            {
+                // без раскрытий обязательный префикс не найдёт ни одного документа
+                if (terms.empty())
+                {
+                    terms.push_back(prefix);
+                }
+                if (terms.size() == 1)
+                {
+                    required_words_set.insert(terms[0]);
+                }
+                else
+                {
+                    query.required_groups.push_back(std::move(terms));
+                }
+            }
+            continue;
+        }
         if (!query_word.is_stop)
         {
             if (query_word.is_minus)
@@ -360,22 +1136,184 @@ SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
             else
             {
                 plus_words_set.insert(query_word.data);
+                if (is_required)
+                {
+                    required_words_set.insert(query_word.data);
+                }
+                else if (expansion_options_.max_edit_distance > 0
+                         && query_word.data.size() >= expansion_options_.min_fuzzy_word_length
+                         && !HasDictionaryWord(query_word.data))
+                {
+                    fuzzy_words.push_back(query_word.data);
+                }
             }
         }
     }
-    query.plus_words.resize(plus_words_set.size());
-    std::transform(plus_words_set.begin(), plus_words_set.end(), query.plus_words.begin(), [](auto word){return word;}) ;
-
-    query.minus_words.resize(minus_words_set.size());
-    std::transform(minus_words_set.begin(), minus_words_set.end(), query.minus_words.begin(), [](auto word){return word;}) ;
-
 
+    // слово, которое есть в запросе без опечатки, сохраняет полный вес
+    std::map<std::string_view, double> fuzzy_weights;
+    for (const std::string_view word : fuzzy_words)
+    {
+        for (const auto &[term, distance] : FindSimilarTerms(word, expansion_options_.max_edit_distance,
+                                                             expansion_options_.max_fuzzy_expansions))
+        {
+            double &weight = fuzzy_weights[term];
+            weight = std::max(weight, std::pow(expansion_options_.fuzzy_penalty, distance));
+        }
+    }
+    for (const auto &[term, weight] : fuzzy_weights)
+    {
+        if (plus_words_set.insert(term).second)
+        {
+            query.term_weights.emplace(term, weight);
+        }
+    }
+    query.plus_words.assign(plus_words_set.begin(), plus_words_set.end());
+    query.minus_words.assign(minus_words_set.begin(), minus_words_set.end());
+    for (const std::string_view word : required_words_set)
+    {
+        query.required_groups.push_back({word});
+    }
 
     return query;
 }
 double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const
 {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+    if (corpus_statistics_ != nullptr)
+    {
+        return ComputeInverseDocumentFreq(ranking_options_.model, corpus_statistics_->document_count,
+                                          corpus_statistics_->GetDocumentFreq(word));
+    }
+    return ComputeInverseDocumentFreq(ranking_options_.model, GetDocumentCount(),
+                                      word_to_document_freqs_.at(word).GetDocumentCount());
+}
+
+double SearchServer::ComputeTermWeight(const Query &query, const std::string_view word) const
+{
+    const auto it = query.term_weights.find(word);
+    const double weight = it == query.term_weights.end() ? 1.0 : it->second;
+    return weight * ComputeWordInverseDocumentFreq(word);
 }
 
+TermScorer SearchServer::MakeTermScorer(const Query &query, const std::string_view word) const
+{
+    const double average_document_length = corpus_statistics_ != nullptr
+                                           ? corpus_statistics_->GetAverageDocumentLength()
+                                           : static_cast<double>(total_document_length_) / GetDocumentCount();
+    return TermScorer(ranking_options_, ComputeTermWeight(query, word), average_document_length);
+}
 
+void SearchServer::SortByDecreasingWeight(Query &query) const
+{
+    std::vector<std::pair<double, std::string_view>> weighted_words;
+    weighted_words.reserve(query.plus_words.size());
+    for (const std::string_view word : query.plus_words)
+    {
+        const auto it = word_to_document_freqs_.find(word);
+        // слов без постингов в индексе нет, им вес не нужен
+        const double weight = it == word_to_document_freqs_.end() || it->second.GetDocumentCount() == 0
+                              ? 0.0
+                              : MakeTermScorer(query, word).GetWeight();
+        weighted_words.emplace_back(weight, word);
+    }
+    std::stable_sort(weighted_words.begin(), weighted_words.end(),
+                     [](const auto &lhs, const auto &rhs) { return lhs.first > rhs.first; });
+    for (size_t i = 0; i < weighted_words.size(); ++i)
+    {
+        query.plus_words[i] = weighted_words[i].second;
+    }
+}
+
+void SearchServer::FlushScoringBlock(const TermScorer &scorer, ScoringBlock &block,
+                                     ScoreAccumulator &document_to_relevance)
+{
+    scorer.ScoreBlock(block.term_freqs.data(), block.document_lengths.data(), block.scores.data(), block.size);
+    for (size_t i = 0; i < block.size; ++i)
+    {
+        document_to_relevance.Add(block.slots[i], block.scores[i]);
+    }
+    block.size = 0;
+}
+
+bool SearchServer::IsMoreRelevant(const Document &lhs, const Document &rhs)
+{
+    if (std::abs(lhs.relevance - rhs.relevance) < EPS)
+    {
+        return lhs.rating > rhs.rating;
+    }
+    else
+    {
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
+void SearchServer::SelectTopDocuments(std::vector<Document> &documents, size_t count)
+{
+    const size_t top_count = std::min(documents.size(), count);
+    partial_sort(documents.begin(), documents.begin() + top_count, documents.end(), IsMoreRelevant);
+    documents.resize(top_count);
+}
+
+void SearchServer::BuildImpactIndex()
+{
+    impact_postings_.clear();
+    index_statistics_.impact_index_bytes = 0;
+    for (const auto &[word, term_postings] : word_to_document_freqs_)
+    {
+        if (term_postings.is_stop_word)
+        {
+            continue;
+        }
+        std::vector<ImpactPosting> postings;
+        postings.reserve(term_postings.GetDocumentCount());
+        for (const auto &status_postings : term_postings.by_status)
+        {
+            for (const auto &[document_id, posting] : status_postings)
+            {
+                const double impact = std::ceil(posting.term_freq * MAX_IMPACT);
+                postings.push_back({static_cast<uint16_t>(std::min<double>(impact, MAX_IMPACT)), document_id});
+            }
+        }
+        std::sort(postings.begin(), postings.end(), [](const ImpactPosting &lhs, const ImpactPosting &rhs)
+                  { return lhs.impact > rhs.impact || (lhs.impact == rhs.impact && lhs.document_id < rhs.document_id); });
+        index_statistics_.impact_index_bytes += postings.capacity() * sizeof(ImpactPosting);
+        impact_postings_.emplace(word, std::move(postings));
+    }
+    has_impact_index_ = true;
+}
+
+bool SearchServer::HasImpactIndex() const
+{
+    return has_impact_index_;
+}
+
+void SearchServer::SetTermExpansionOptions(const TermExpansionOptions &options)
+{
+    expansion_options_ = options;
+}
+
+const TermExpansionOptions &SearchServer::GetTermExpansionOptions() const
+{
+    return expansion_options_;
+}
+
+void SearchServer::SetRankingOptions(const RankingOptions &options)
+{
+    ranking_options_ = options;
+}
+
+const RankingOptions &SearchServer::GetRankingOptions() const
+{
+    return ranking_options_;
+}
+
+void SearchServer::SetCorpusStatistics(const CorpusStatistics *statistics)
+{
+    corpus_statistics_ = statistics;
+}
+
+int SearchServer::GetDocumentLength(int document_id) const
+{
+    const auto it = documents_.find(document_id);
+    return it != documents_.end() ? length_by_slot_[it->second.slot] : 0;
+}
@@ -17,19 +17,74 @@
 #include <future>
 #include <mutex>
 #include <unordered_set>
+#include <array>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 
+#include "analyzer.h"
 #include "document.h"
+#include "document_filters.h"
+#include "index_statistics.h"
+#include "memory_resources.h"
+#include "metrics.h"
+#include "query_control.h"
+#include "query_profile.h"
+#include "score_accumulator.h"
+#include "scoring.h"
+#include "stop_words.h"
 #include "string_processing.h"
 
 
 #include "concurrent_map.h"
 
+struct CorpusStatistics;
+
 using namespace std::literals::string_literals; // шта? а как приставить к оператору s std?
 
 
 // нешаблонные выносить
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPS = 0.0001;
+// через сколько постингов проверяется дедлайн запроса
+const int POSTING_BLOCK_SIZE = 256;
+
+// Раскрытие слов запроса в несколько слов словаря
+struct TermExpansionOptions
+{
+    // "префикс*" заменяется на столько самых частых слов с этим префиксом;
+    // -префикс* исключает все такие слова
+    size_t max_prefix_expansions = 16;
+
+    // Плюс-слово, которого нет в словаре, заменяется на слова на расстоянии Левенштейна
+    // не больше max_edit_distance (0 - нечёткий поиск выключен). Вклад такого слова
+    // умножается на fuzzy_penalty в степени расстояния
+    int max_edit_distance = 0;
+    double fuzzy_penalty = 0.5;
+    size_t max_fuzzy_expansions = 8;
+    size_t min_fuzzy_word_length = 4;
+};
+
+// Документ, разобранный на слова без доступа к индексу: TokenizeDocument можно вызывать
+// из нескольких потоков, а вставка AddDocument(TokenizedDocument) остаётся последовательной
+struct TokenizedDocument
+{
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string text;
+    // все слова, включая стоп-слова: смещение и длина в text
+    std::vector<std::pair<uint32_t, uint32_t>> words;
+};
+
+// Число документов, в которых встречается слово
+struct TermVolume
+{
+    std::string word;
+    size_t document_count = 0;
+    bool is_stop_word = false;
+};
 
 class SearchServer
 {
@@ -38,15 +93,83 @@ public:
     explicit SearchServer(const std::string &stop_words_text);
     explicit SearchServer(const std::string_view stop_words_text);
 
-    std::set<int>::const_iterator begin();
-    std::set<int>::const_iterator end();
+    // Контейнеры индекса держат указатели на пулы сервера: перемещение забирает пулы вместе
+    // с ними, а присваивание смешало бы память двух серверов. Копирования нет: копия осталась бы
+    // на пулах и текстах исходного сервера. Второй сервер строится заново через AddDocument
+    SearchServer(SearchServer &&) = default;
+    SearchServer(const SearchServer &) = delete;
+    SearchServer &operator=(const SearchServer &) = delete;
+    SearchServer &operator=(SearchServer &&) = delete;
+
+    std::set<int>::const_iterator begin() const;
+    std::set<int>::const_iterator end() const;
     void AddDocument(int document_id, const std::string &document, DocumentStatus status, const std::vector<int> &ratings);
+    // document должен быть получен TokenizeDocument этого сервера
+    void AddDocument(TokenizedDocument document);
+    TokenizedDocument TokenizeDocument(int document_id, std::string text, DocumentStatus status,
+                                       std::vector<int> ratings) const;
     int GetDocumentCount() const;
     void RemoveDocument(std::execution::sequenced_policy, int document_id);
     void RemoveDocument(std::execution::parallel_policy, int document_id);
     void RemoveDocument(int document_id);
+    // Удаление пачкой: документы сначала помечаются удалёнными, затем постинги чистятся одним
+    // проходом, сгруппированным по словам, параллельно по словам. Неизвестные id пропускаются
+    void RemoveDocuments(const std::vector<int> &document_ids);
+    // переносит постинги документа в раздел нового статуса, не разбирая текст заново
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    // Режим упорядоченных по вкладу постингов: пока индекс актуален, последовательный
+    // FindTopDocuments останавливается, как только непрочитанные постинги уже не могут
+    // попасть в топ. AddDocument сбрасывает индекс, его нужно строить заново.
+    void BuildImpactIndex();
+    bool HasImpactIndex() const;
+
+    void SetTermExpansionOptions(const TermExpansionOptions &options);
+    const TermExpansionOptions &GetTermExpansionOptions() const;
+
+    // Модель ранжирования по умолчанию - TF-IDF. Упорядоченные по вкладу постинги
+    // используются только с TF-IDF, с BM25 запросы идут обычным путём
+    void SetRankingOptions(const RankingOptions &options);
+    const RankingOptions &GetRankingOptions() const;
+
+    // Внешняя статистика для idf и BM25 вместо собственной (nullptr - своя). Нужна шардам
+    // ShardedSearchServer; статистика должна жить дольше сервера и не меняться во время запросов.
+    // Префиксы и опечатки тогда раскрываются по словарю статистики, а не по своему, поэтому
+    // все шарды получают те же слова, что и один сервер со всеми документами
+    void SetCorpusStatistics(const CorpusStatistics *statistics);
+
+    // число слов документа без стоп-слов, 0 для неизвестного id
+    int GetDocumentLength(int document_id) const;
+
+    // Постинги хранятся для всех слов, стоп-слова только не попадают в запросы, поэтому их
+    // можно менять без переиндексации. Длина документа и term_freq слов остаются такими, какими
+    // были при добавлении документа. Упорядоченные по вкладу постинги сбрасываются
+    template <typename StringContainer>
+    void SetStopWords(const StringContainer &stop_words);
+    void SetStopWords(const std::string &stop_words_text);
+    void SetStopWords(std::string_view stop_words_text);
+    bool IsStopWord(const std::string_view word) const;
+
+    // Объём постингов стоп-слов и самых частых остальных слов, по убыванию: по нему видно,
+    // сколько индекса занимают стоп-слова и какие слова дешевле всего сделать стоп-словами
+    std::vector<TermVolume> GetStopWordVolumes() const;
+    std::vector<TermVolume> GetHeaviestTerms(size_t count) const;
+
+    // Нормализация текста документов, запросов и стоп-слов. Задаётся до добавления документов:
+    // индекс хранит слова уже в нормальной форме. Текущие стоп-слова приводятся новым анализатором
+    void SetAnalyzerOptions(const AnalyzerOptions &options);
+    const AnalyzerOptions &GetAnalyzerOptions() const;
+
+    static bool IsMoreRelevant(const Document &lhs, const Document &rhs);
     static std::vector<std::string_view>  SplitIntoWords(std::string_view text) ;
-    const std::map<std::string_view, double> &GetWordFrequencies(int document_id) const;
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    // все слова документа, включая стоп-слова
+    const std::pmr::map<std::string_view, double> &GetWordFrequencies(int document_id) const;
+
+    // память индекса и арен запросов по аллокаторам
+    IndexMemoryStats GetMemoryStats() const;
+    // размер индекса по частям, O(1)
+    IndexStatistics GetIndexStatistics() const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::sequenced_policy, const std::string_view raw_query, int document_id) const;
@@ -55,15 +178,7 @@ public:
     template <typename StringContainer>
     explicit SearchServer(const StringContainer &stop_words)
     {
-        auto container = MakeUniqueNonEmptyStrings(stop_words);
-        for (const auto &word : container)
-        {
-            if (!IsValidWord(std::string_view(word)))
-            {
-                throw std::invalid_argument("Invalid stop word");
-            }
-        }
-        stop_words_ = container;
+        SetStopWords(stop_words);
     }
     std::vector<Document> FindTopDocuments( const std::string_view raw_query, DocumentStatus status_seek ) const;
     std::vector<Document> FindTopDocuments( const std::string_view raw_query) const;
@@ -81,6 +196,44 @@ public:
     template <typename ExecutionPolicy, typename Predicate>
     std::vector<Document> FindTopDocuments( ExecutionPolicy policy , const std::string_view raw_query,
                                             Predicate predicate ) const;
+
+    // Ранжируются только (page_index + 1) * page_size лучших документов
+    std::vector<Document> FindTopDocumentsPage(const std::string_view raw_query, size_t page_index, size_t page_size,
+                                               DocumentStatus status_seek = DocumentStatus::ACTUAL) const;
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocumentsPage(const std::string_view raw_query, size_t page_index, size_t page_size,
+                                               Predicate predicate) const;
+
+    SearchResult FindTopDocumentsUntil(const QueryDeadline &deadline, const std::string_view raw_query,
+                                       DocumentStatus status_seek = DocumentStatus::ACTUAL) const;
+
+    template <typename Predicate>
+    SearchResult FindTopDocumentsUntil(const QueryDeadline &deadline, const std::string_view raw_query,
+                                       Predicate predicate) const;
+
+    // Запрос с ограничением по времени и числу постингов, см. QueryBudget
+    SearchResult FindTopDocumentsWithin(const QueryBudget &budget, const std::string_view raw_query,
+                                        DocumentStatus status_seek = DocumentStatus::ACTUAL) const;
+
+    template <typename Predicate>
+    SearchResult FindTopDocumentsWithin(const QueryBudget &budget, const std::string_view raw_query,
+                                        Predicate predicate) const;
+
+    // Результат вместе с разбором запроса по фазам; обычные FindTopDocuments профиль не собирают
+    ProfiledSearchResult FindTopDocumentsWithProfile(const std::string_view raw_query,
+                                                     DocumentStatus status_seek = DocumentStatus::ACTUAL) const;
+
+    template <typename Predicate>
+    ProfiledSearchResult FindTopDocumentsWithProfile(const std::string_view raw_query, Predicate predicate) const;
+
+    // сервер не должен изменяться и разрушаться, пока future не готов
+    std::future<SearchResult> FindTopDocumentsAsync(std::string raw_query, QueryDeadline deadline,
+                                                    DocumentStatus status_seek = DocumentStatus::ACTUAL) const;
+
+    template <typename Predicate>
+    std::future<SearchResult> FindTopDocumentsAsync(std::string raw_query, QueryDeadline deadline,
+                                                    Predicate predicate) const;
 private:
 
     struct QueryWord
@@ -89,48 +242,385 @@ private:
         bool is_minus;
         bool is_stop;
     };
+    // plus_words - все слова, дающие вклад в релевантность, включая обязательные и слова фраз.
+    // Документ должен содержать хотя бы одно слово из каждой required_groups (+слово - группа
+    // из одного слова, +(a b) - из нескольких), все phrases подряд и ни одной из minus_phrases.
+    // Незакрытые кавычка и скобка остаются символами слова; ведущий "+" всегда оператор
     struct Query
     {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        std::vector<std::vector<std::string_view>> required_groups;
+        std::vector<std::vector<std::string_view>> phrases;
+        std::vector<std::vector<std::string_view>> minus_phrases;
+        // множители idf слов, подставленных вместо слов с опечатками; у остальных слов множитель 1
+        std::map<std::string_view, double> term_weights;
+        // при включённом анализаторе слова запроса ссылаются на его нормализованную копию
+        std::shared_ptr<const std::string> normalized_text;
+
+        // только плюс- и минус-слова, как до появления операторов
+        bool IsPlain() const
+        {
+            return required_groups.empty() && minus_phrases.empty();
+        }
+    };
+
+    // Control управляет ядром FindAllDocuments: ShouldStop() вызывается между блоками постингов,
+    // остальные методы - точки наблюдения, пустые у всех, кроме ProfiledQuery
+    struct UnboundedQuery
+    {
+        static constexpr bool ShouldStop()
+        {
+            return false;
+        }
+
+        static NoPhaseTimer TimePhase(MetricPhase)
+        {
+            return {};
+        }
+
+        static void OnPlusTerm(std::string_view, size_t, double)
+        {
+        }
+
+        static void OnMinusTerm(std::string_view, size_t)
+        {
+        }
+
+        static void OnPostingsVisited(size_t)
+        {
+        }
+
+        // вызывается по мере оценки постингов плюс-слов, в отличие от OnPostingsVisited - поблочно
+        static void OnPostingsScored(size_t)
+        {
+        }
+
+        static void OnPredicateReject()
+        {
+        }
+
+        static void OnMinusExclusion()
+        {
+        }
+
+        static void OnDocumentsScored(size_t)
+        {
+        }
+    };
+
+    class BudgetedQuery : public UnboundedQuery
+    {
+    public:
+        BudgetedQuery(const QueryDeadline &deadline, size_t max_postings)
+            : deadline_(deadline), max_postings_(max_postings)
+        {
+        }
+
+        bool ShouldStop()
+        {
+            if (!stopped_ && (postings_scored_ >= max_postings_ || deadline_.IsExpired()))
+            {
+                stopped_ = true;
+            }
+            return stopped_;
+        }
+
+        void OnPostingsScored(size_t count)
+        {
+            postings_scored_ += count;
+        }
+
+        bool IsStopped() const
+        {
+            return stopped_;
+        }
+
+        size_t GetPostingsScored() const
+        {
+            return postings_scored_;
+        }
+
+    private:
+        const QueryDeadline &deadline_;
+        size_t max_postings_;
+        size_t postings_scored_ = 0;
+        bool stopped_ = false;
     };
-    std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document2words_freqs;
+
+    class ProfiledQuery : public UnboundedQuery
+    {
+    public:
+        explicit ProfiledQuery(QueryProfile &profile) : profile_(profile)
+        {
+        }
+
+        PhaseTimer TimePhase(MetricPhase phase)
+        {
+            return PhaseTimer(profile_.phase_durations[static_cast<int>(phase)]);
+        }
+
+        void OnPlusTerm(std::string_view word, size_t posting_count, double inverse_document_freq)
+        {
+            profile_.plus_terms.push_back({std::string(word), posting_count, inverse_document_freq});
+        }
+
+        void OnMinusTerm(std::string_view word, size_t posting_count)
+        {
+            profile_.minus_terms.push_back({std::string(word), posting_count, 0.0});
+        }
+
+        void OnPostingsVisited(size_t count)
+        {
+            profile_.postings_visited += count;
+        }
+
+        void OnPredicateReject()
+        {
+            ++profile_.predicate_rejects;
+        }
+
+        void OnMinusExclusion()
+        {
+            ++profile_.minus_exclusions;
+        }
+
+        void OnDocumentsScored(size_t count)
+        {
+            profile_.documents_scored += count;
+        }
+
+    private:
+        QueryProfile &profile_;
+    };
+
+    StopWordSet stop_words_;
+    // стоп-слова в том виде, в каком их задали, до анализатора
+    std::vector<std::string> raw_stop_words_;
+    Analyzer analyzer_;
+
+    // Узлы постингов и прямого индекса берутся из пулов, временные структуры запроса - из
+    // QueryArena. Пулы объявлены раньше контейнеров и разрушаются после них
+    struct IndexMemory
+    {
+        NodePool dictionary;
+        NodePool postings;
+        NodePool forward_index;
+        CountingMemoryResource query_arenas;
+    };
+    std::unique_ptr<IndexMemory> memory_ = std::make_unique<IndexMemory>();
+
+    // слот лежит в постинге рядом с term_freq, чтобы ядра читали колонки без поиска по id
+    struct Posting
+    {
+        double term_freq = 0.0;
+        int slot = 0;
+    };
+    using Postings = std::pmr::map<int, Posting>;
+
+    // постинги слова разбиты по статусу документа: запрос с фильтром по статусу читает только свой раздел
+    struct TermPostings
+    {
+        std::array<Postings, DOCUMENT_STATUS_COUNT> by_status;
+        // слово сейчас стоп-слово: его постинги не читаются запросами и не раскрываются из префиксов
+        bool is_stop_word = false;
+
+        explicit TermPostings(std::pmr::memory_resource *resource)
+            : TermPostings(resource, std::make_index_sequence<DOCUMENT_STATUS_COUNT>())
+        {
+        }
+
+        Postings &For(DocumentStatus status)
+        {
+            return by_status[static_cast<int>(status)];
+        }
+
+        const Postings &For(DocumentStatus status) const
+        {
+            return by_status[static_cast<int>(status)];
+        }
+
+        size_t GetDocumentCount() const
+        {
+            size_t result = 0;
+            for (const auto &postings : by_status)
+            {
+                result += postings.size();
+            }
+            return result;
+        }
+
+    private:
+        template <size_t... Statuses>
+        TermPostings(std::pmr::memory_resource *resource, std::index_sequence<Statuses...>)
+            : by_status{((void)Statuses, Postings(resource))...}
+        {
+        }
+    };
+
+    // узлы словаря и списки постингов внутри них живут в разных пулах
+    std::pmr::map<std::string_view, TermPostings> word_to_document_freqs_{memory_->dictionary.GetResource()};
+    std::pmr::map<int, std::pmr::map<std::string_view, double>> document2words_freqs{memory_->forward_index.GetResource()};
+    // все слова документа, включая стоп-слова, в исходном порядке: по ним проверяются фразы
+    std::map<int, std::vector<std::string_view>> document_words_;
     std::list<std::string> documents_texts;
     std::map<int, DocumentData> documents_;
     std::set<int> index_to_id;
 
+    // impact - term_freq, округлённый вверх до 1 / MAX_IMPACT; постинги слова идут по убыванию impact
+    struct ImpactPosting
+    {
+        uint16_t impact;
+        int document_id;
+    };
+    static const int MAX_IMPACT = 65535;
+    std::map<std::string_view, std::vector<ImpactPosting>> impact_postings_;
+    bool has_impact_index_ = false;
+    TermExpansionOptions expansion_options_;
+    RankingOptions ranking_options_;
+    const CorpusStatistics *corpus_statistics_ = nullptr;
+    // колонки по плотному слоту документа для проверки фильтров без поиска в documents_.
+    // Слот освобождённого документа достаётся следующему добавленному, поэтому размер колонок -
+    // наибольшее число документов за время жизни сервера, а не наибольший id
+    std::vector<int> id_by_slot_;
+    std::vector<DocumentStatus> status_by_slot_;
+    std::vector<int> rating_by_slot_;
+    // число слов документа без стоп-слов, для BM25
+    std::vector<int> length_by_slot_;
+    std::vector<int> free_slots_;
+    long long total_document_length_ = 0;
+    IndexStatistics index_statistics_;
 
-    bool IsValidWord(const std::string_view word) const;
-    bool IsStopWord(const std::string_view word) const;
-
+    // постинги одного слова в виде отдельных массивов, чтобы оценивать их одним вызовом TermScorer::ScoreBlock
+    struct ScoringBlock
+    {
+        std::array<int, POSTING_BLOCK_SIZE> slots;
+        std::array<double, POSTING_BLOCK_SIZE> term_freqs;
+        std::array<double, POSTING_BLOCK_SIZE> document_lengths;
+        std::array<double, POSTING_BLOCK_SIZE> scores;
+        size_t size = 0;
+    };
 
 
+    bool IsValidWord(const std::string_view word) const;
+    void ApplyStopWords(std::vector<std::string> stop_words);
+    // снимает документ с учёта и возвращает его статус; постинги и прямой индекс не трогает
+    DocumentStatus MarkRemoved(int document_id);
+    void CompactPostings(const std::vector<std::pair<int, DocumentStatus>> &removed);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
 
 
     static int ComputeAverageRating(const std::vector<int> &ratings);
     QueryWord ParseQueryWord(std::string_view text) const;
     bool IsInvalidQueryWord(std::string_view word) const;
     Query ParseQuery(const std::string_view text) const;
+    std::vector<std::string_view> ParseWordSequence(std::string_view text) const;
+    std::vector<std::string_view> ExpandPrefix(std::string_view prefix, size_t max_count) const;
+    std::vector<std::pair<std::string_view, int>> FindSimilarTerms(std::string_view word, int max_distance,
+                                                                   size_t max_count) const;
+    // раскрытия по упорядоченному словарю; document_count(элемент словаря) - 0 для слов,
+    // которые раскрывать нельзя
+    template <typename Dictionary, typename DocumentCount>
+    static std::vector<std::string_view> ExpandPrefix(const Dictionary &dictionary, DocumentCount document_count,
+                                                      std::string_view prefix, size_t max_count);
+    template <typename Dictionary, typename DocumentCount>
+    static std::vector<std::pair<std::string_view, int>> FindSimilarTerms(const Dictionary &dictionary,
+                                                                          DocumentCount document_count,
+                                                                          std::string_view word, int max_distance,
+                                                                          size_t max_count);
+    bool HasDictionaryWord(std::string_view word) const;
     double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    double ComputeTermWeight(const Query &query, const std::string_view word) const;
+    TermScorer MakeTermScorer(const Query &query, const std::string_view word) const;
+    // порядок для прерываемых запросов: у редких слов больше вклад на постинг и короче списки
+    void SortByDecreasingWeight(Query &query) const;
+    template <typename Predicate>
+    SearchResult FindTopDocumentsBounded(const QueryDeadline &deadline, size_t max_postings,
+                                         const std::string_view raw_query, Predicate predicate) const;
+    static void FlushScoringBlock(const TermScorer &scorer, ScoringBlock &block,
+                                  ScoreAccumulator &document_to_relevance);
+
+    template <typename Predicate>
+    bool IsAccepted(const Predicate &predicate, int document_id, int slot) const;
+    template <typename Predicate>
+    static bool CanAcceptStatus(const Predicate &predicate, DocumentStatus status);
+    bool ContainsDocument(const TermPostings &postings, int document_id) const;
+    bool ContainsPhrase(int document_id, const std::vector<std::string_view> &phrase) const;
+    bool MatchesPhrases(const Query &query, int document_id) const;
+    bool MatchesConstraints(const Query &query, int document_id) const;
+    std::vector<int> IntersectRequiredGroups(const Query &query, DocumentStatus status) const;
+    static void SelectTopDocuments(std::vector<Document> &documents, size_t count = MAX_RESULT_DOCUMENT_COUNT);
 
     template <typename Predicate>
     std::vector<Document> FindAllDocuments( const Query &query, Predicate predicate) const;
 
+    template <typename Predicate, typename Control>
+    std::vector<Document> FindAllDocuments(const Query &query, Predicate predicate, Control &control) const;
+
     template <typename Predicate, typename ExecutionPolicy>
     std::vector<Document> FindAllDocuments(ExecutionPolicy policy, const Query &query, Predicate predicate) const ;
+
+    template <typename Predicate, typename Control>
+    std::vector<Document> FindRequiredDocuments(const Query &query, Predicate predicate, Control &control) const;
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocumentsByImpact(const Query &query, Predicate predicate, size_t count) const;
 };
 
 
 
 
+template <typename StringContainer>
+void SearchServer::SetStopWords(const StringContainer &stop_words)
+{
+    const auto container = MakeUniqueNonEmptyStrings(stop_words);
+    for (const auto &word : container)
+    {
+        if (!IsValidWord(std::string_view(word)))
+        {
+            throw std::invalid_argument("Invalid stop word");
+        }
+    }
+    ApplyStopWords(std::vector<std::string>(container.begin(), container.end()));
+}
+
 template <typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments( ExecutionPolicy policy , const std::string_view raw_query, DocumentStatus status_seek  ) const{
-    return SearchServer::FindTopDocuments(policy ,raw_query, [status_seek]([[maybe_unused]] int document_id, DocumentStatus status, [[maybe_unused]] int rating)
-    { return status == status_seek; } );
+    return SearchServer::FindTopDocuments(policy, raw_query, StatusFilter{status_seek});
+}
+
+template <typename Predicate>
+bool SearchServer::IsAccepted(const Predicate &predicate, int document_id, [[maybe_unused]] int slot) const
+{
+    if constexpr (std::is_same_v<Predicate, StatusFilter>)
+    {
+        return status_by_slot_[slot] == predicate.status;
+    }
+    else if constexpr (std::is_same_v<Predicate, RatingRangeFilter>)
+    {
+        return predicate.Contains(rating_by_slot_[slot]);
+    }
+    else if constexpr (std::is_same_v<Predicate, IdSetFilter>)
+    {
+        return predicate.Contains(document_id);
+    }
+    else
+    {
+        return predicate(document_id, status_by_slot_[slot], rating_by_slot_[slot]);
+    }
+}
+
+template <typename Predicate>
+bool SearchServer::CanAcceptStatus([[maybe_unused]] const Predicate &predicate, [[maybe_unused]] DocumentStatus status)
+{
+    if constexpr (std::is_same_v<Predicate, StatusFilter>)
+    {
+        return predicate.status == status;
+    }
+    else
+    {
+        return true;
+    }
 }
 
 template <typename ExecutionPolicy>
@@ -149,31 +639,104 @@ template <typename ExecutionPolicy, typename Predicate>
 std::vector<Document> SearchServer::FindTopDocuments( ExecutionPolicy policy , const std::string_view raw_query,
                                         Predicate predicate ) const
 {
+    METRIC_INCREMENT(MetricCounter::QUERIES, 1);
+    Query query;
+    {
+        METRIC_TIMER(MetricPhase::PARSE);
+        query = ParseQuery(raw_query);
+    }
 
-    Query query = ParseQuery(raw_query);
+    if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>)
+    {
+        if (has_impact_index_ && query.IsPlain() && ranking_options_.model == RankingModel::TF_IDF)
+        {
+            METRIC_TIMER(MetricPhase::SCORING);
+            return FindTopDocumentsByImpact(query, predicate, MAX_RESULT_DOCUMENT_COUNT);
+        }
+    }
 
     std::vector<Document> result = SearchServer::FindAllDocuments(policy, query, predicate);
-
-    sort(result.begin(), result.end(),
-         [](const Document &lhs, const Document &rhs)
-         {
-             if (std::abs(lhs.relevance - rhs.relevance) < EPS)
-             {
-                 return lhs.rating > rhs.rating;
-             }
-             else
-             {
-                 return lhs.relevance > rhs.relevance;
-             }
-         });
-    if (result.size() > MAX_RESULT_DOCUMENT_COUNT)
-    {
-        result.resize(MAX_RESULT_DOCUMENT_COUNT);
+    {
+        METRIC_TIMER(MetricPhase::TOP_K);
+        SelectTopDocuments(result);
     }
 
     return result;
 }
 
+template <typename Predicate>
+std::vector<Document> SearchServer::FindTopDocumentsPage(const std::string_view raw_query, size_t page_index,
+                                                         size_t page_size, Predicate predicate) const
+{
+    const Query query = ParseQuery(raw_query);
+
+    std::vector<Document> result = SearchServer::FindAllDocuments(query, predicate);
+    const size_t page_begin = std::min(result.size(), page_index * page_size);
+    SelectTopDocuments(result, page_begin + page_size);
+    result.erase(result.begin(), result.begin() + page_begin);
+
+    return result;
+}
+
+template <typename Predicate>
+SearchResult SearchServer::FindTopDocumentsUntil(const QueryDeadline &deadline, const std::string_view raw_query,
+                                                 Predicate predicate) const
+{
+    return FindTopDocumentsBounded(deadline, std::numeric_limits<size_t>::max(), raw_query, predicate);
+}
+
+template <typename Predicate>
+SearchResult SearchServer::FindTopDocumentsWithin(const QueryBudget &budget, const std::string_view raw_query,
+                                                  Predicate predicate) const
+{
+    const QueryDeadline deadline = budget.Start();
+    return FindTopDocumentsBounded(deadline, budget.max_postings, raw_query, predicate);
+}
+
+template <typename Predicate>
+SearchResult SearchServer::FindTopDocumentsBounded(const QueryDeadline &deadline, size_t max_postings,
+                                                   const std::string_view raw_query, Predicate predicate) const
+{
+    Query query = ParseQuery(raw_query);
+    SortByDecreasingWeight(query);
+
+    BudgetedQuery control(deadline, max_postings);
+    SearchResult result;
+    result.documents = FindAllDocuments(query, predicate, control);
+    result.is_partial = control.IsStopped();
+    result.postings_scored = control.GetPostingsScored();
+    SelectTopDocuments(result.documents);
+
+    return result;
+}
+
+template <typename Predicate>
+ProfiledSearchResult SearchServer::FindTopDocumentsWithProfile(const std::string_view raw_query, Predicate predicate) const
+{
+    ProfiledSearchResult result;
+    ProfiledQuery control(result.profile);
+    Query query;
+    {
+        [[maybe_unused]] const auto timer = control.TimePhase(MetricPhase::PARSE);
+        query = ParseQuery(raw_query);
+    }
+    result.documents = FindAllDocuments(query, predicate, control);
+    {
+        [[maybe_unused]] const auto timer = control.TimePhase(MetricPhase::TOP_K);
+        SelectTopDocuments(result.documents);
+    }
+    return result;
+}
+
+template <typename Predicate>
+std::future<SearchResult> SearchServer::FindTopDocumentsAsync(std::string raw_query, QueryDeadline deadline,
+                                                              Predicate predicate) const
+{
+    return std::async(std::launch::async,
+                      [this, raw_query = std::move(raw_query), deadline = std::move(deadline), predicate]()
+                      { return FindTopDocumentsUntil(deadline, raw_query, predicate); });
+}
+
 template <typename Predicate>
 std::vector<Document> SearchServer::FindAllDocuments( const Query &query, Predicate predicate) const{
     return SearchServer::FindAllDocuments(std::execution::seq, query, predicate);
@@ -185,17 +748,27 @@ std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy policy, con
 
 
     if constexpr (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>){
+        if (!query.IsPlain()) {
+            // пересечение постингов последовательное по своей природе
+            UnboundedQuery control;
+            return SearchServer::FindAllDocuments(query, predicate, control);
+        }
+        METRIC_TIMER(MetricPhase::SCORING);
         ConcurrentMap<int, double> document_to_relevance(1000);
         std::for_each(policy, query.plus_words.begin(), query.plus_words.end(),
                       [&](auto& word) {
                           if (word_to_document_freqs_.count(word) == 0) {
                               return;
                           }
-                          const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(word);
-                          for (const auto [document_id, term_freq]: word_to_document_freqs_.at(word)) {
-                              if (predicate(document_id, documents_.at(document_id).status,
-                                            documents_.at(document_id).rating)) {
-                                  document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+                          const TermScorer scorer = MakeTermScorer(query, word);
+                          for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+                              if (!CanAcceptStatus(predicate, static_cast<DocumentStatus>(status))) {
+                                  continue;
+                              }
+                              for (const auto &[document_id, posting]: word_to_document_freqs_.at(word).by_status[status]) {
+                                  if (IsAccepted(predicate, document_id, posting.slot)) {
+                                      document_to_relevance[posting.slot].ref_to_value += scorer.Score(posting.term_freq, length_by_slot_[posting.slot]);
+                                  }
                               }
                           }
                       });
@@ -203,54 +776,330 @@ std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy policy, con
             if (word_to_document_freqs_.count(word) == 0) {
                 return;
             }
-            for (const auto [document_id, _]: word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+            for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+                if (!CanAcceptStatus(predicate, static_cast<DocumentStatus>(status))) {
+                    continue;
+                }
+                for (const auto &[_, posting]: word_to_document_freqs_.at(word).by_status[status]) {
+                    document_to_relevance.erase(posting.slot);
+                }
             }
         });
         std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance]: document_to_relevance.BuildOrdinaryMap()) {
+        for (const auto [slot, relevance]: document_to_relevance.BuildOrdinaryMap()) {
             matched_documents.push_back(
-                    {document_id, relevance, documents_.at(document_id).rating});
+                    {id_by_slot_[slot], relevance, rating_by_slot_[slot]});
         }
         return matched_documents;
     }else {
-        std::map<int, double> document_to_relevance;
+        UnboundedQuery control;
+        return SearchServer::FindAllDocuments(query, predicate, control);
+    }
+
+
+}
+
+template <typename Predicate, typename Control>
+std::vector<Document> SearchServer::FindAllDocuments(const Query &query, Predicate predicate, Control &control) const
+{
+    if (!query.required_groups.empty())
+    {
+        return FindRequiredDocuments(query, predicate, control);
+    }
+
+    // один аккумулятор на поток: повторные запросы не выделяют память под суммы. Размер - число
+    // слотов, то есть наибольшее число документов сервера, а не наибольший id
+    static thread_local ScoreAccumulator document_to_relevance;
+    document_to_relevance.Reset(id_by_slot_.size());
+    {
+        METRIC_TIMER(MetricPhase::SCORING);
+        [[maybe_unused]] const auto timer = control.TimePhase(MetricPhase::SCORING);
+        ScoringBlock block;
         for (const std::string_view word : query.plus_words)
         {
+            if (control.ShouldStop())
+            {
+                break;
+            }
             if (word_to_document_freqs_.count(word) == 0)
             {
                 continue;
             }
-            const double inverse_document_freq = SearchServer::ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word))
+            const TermPostings &term_postings = word_to_document_freqs_.at(word);
+            const TermScorer scorer = MakeTermScorer(query, word);
+            control.OnPlusTerm(word, term_postings.GetDocumentCount(), scorer.GetWeight());
+            int block_left = POSTING_BLOCK_SIZE;
+            for (int status = 0; status < DOCUMENT_STATUS_COUNT && !control.ShouldStop(); ++status)
             {
-                if (predicate(document_id, documents_.at(document_id).status, documents_.at(document_id).rating))
+                if (!CanAcceptStatus(predicate, static_cast<DocumentStatus>(status)))
+                {
+                    continue;
+                }
+                const auto &postings = term_postings.by_status[status];
+                METRIC_INCREMENT(MetricCounter::POSTINGS_VISITED, postings.size());
+                control.OnPostingsVisited(postings.size());
+                for (const auto &[document_id, posting] : postings)
                 {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                    // блок засчитывается целиком, когда прочитан; остановка - до следующего постинга
+                    if (block_left == 0)
+                    {
+                        block_left = POSTING_BLOCK_SIZE;
+                        control.OnPostingsScored(POSTING_BLOCK_SIZE);
+                        if (control.ShouldStop())
+                        {
+                            break;
+                        }
+                    }
+                    --block_left;
+                    if (IsAccepted(predicate, document_id, posting.slot))
+                    {
+                        block.slots[block.size] = posting.slot;
+                        block.term_freqs[block.size] = posting.term_freq;
+                        block.document_lengths[block.size] = length_by_slot_[posting.slot];
+                        if (++block.size == POSTING_BLOCK_SIZE)
+                        {
+                            FlushScoringBlock(scorer, block, document_to_relevance);
+                        }
+                    }
+                    else
+                    {
+                        control.OnPredicateReject();
+                    }
                 }
             }
+            FlushScoringBlock(scorer, block, document_to_relevance);
+            control.OnPostingsScored(POSTING_BLOCK_SIZE - block_left);
         }
+    }
+    control.OnDocumentsScored(document_to_relevance.GetSize());
+    METRIC_INCREMENT(MetricCounter::DOCUMENTS_SCORED, document_to_relevance.GetSize());
 
+    // минус-слова применяются и к частичному результату
+    {
+        METRIC_TIMER(MetricPhase::MINUS_FILTER);
+        [[maybe_unused]] const auto timer = control.TimePhase(MetricPhase::MINUS_FILTER);
         for (std::string_view word : query.minus_words)
         {
             if (word_to_document_freqs_.count(word) == 0)
             {
                 continue;
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word))
+            const TermPostings &term_postings = word_to_document_freqs_.at(word);
+            control.OnMinusTerm(word, term_postings.GetDocumentCount());
+            for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status)
             {
-                document_to_relevance.erase(document_id);
+                if (!CanAcceptStatus(predicate, static_cast<DocumentStatus>(status)))
+                {
+                    continue;
+                }
+                control.OnPostingsVisited(term_postings.by_status[status].size());
+                for (const auto &[_, posting] : term_postings.by_status[status])
+                {
+                    if (document_to_relevance.Erase(posting.slot))
+                    {
+                        control.OnMinusExclusion();
+                    }
+                }
             }
         }
+        if (!query.minus_phrases.empty())
+        {
+            document_to_relevance.ForEach([&](int slot, double)
+            {
+                if (!MatchesPhrases(query, id_by_slot_[slot]))
+                {
+                    document_to_relevance.Erase(slot);
+                    control.OnMinusExclusion();
+                }
+            });
+        }
+    }
 
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance)
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(document_to_relevance.GetSize());
+    document_to_relevance.ForEach([&](int slot, double relevance)
+    {
+        matched_documents.push_back({id_by_slot_[slot], relevance, rating_by_slot_[slot]});
+    });
+    return matched_documents;
+}
+
+// Кандидаты - пересечение постингов обязательных групп; каждый кандидат проверяется и
+// оценивается целиком по прямому индексу, поэтому полные списки необязательных слов не читаются
+template <typename Predicate, typename Control>
+std::vector<Document> SearchServer::FindRequiredDocuments(const Query &query, Predicate predicate, Control &control) const
+{
+    std::vector<std::pair<std::string_view, TermScorer>> plus_words;
+    for (const std::string_view word : query.plus_words)
+    {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it == word_to_document_freqs_.end() || it->second.GetDocumentCount() == 0)
         {
-            matched_documents.push_back(
-                    {document_id, relevance, documents_.at(document_id).rating});
+            continue;
         }
-        return matched_documents;
+        const TermScorer scorer = MakeTermScorer(query, word);
+        control.OnPlusTerm(word, it->second.GetDocumentCount(), scorer.GetWeight());
+        plus_words.emplace_back(word, scorer);
+    }
+
+    std::vector<Document> matched_documents;
+    size_t candidate_count = 0;
+    {
+        METRIC_TIMER(MetricPhase::SCORING);
+        [[maybe_unused]] const auto timer = control.TimePhase(MetricPhase::SCORING);
+        int block_left = POSTING_BLOCK_SIZE;
+        for (int status = 0; status < DOCUMENT_STATUS_COUNT && !control.ShouldStop(); ++status)
+        {
+            if (!CanAcceptStatus(predicate, static_cast<DocumentStatus>(status)))
+            {
+                continue;
+            }
+            const std::vector<int> candidates = IntersectRequiredGroups(query, static_cast<DocumentStatus>(status));
+            candidate_count += candidates.size();
+            METRIC_INCREMENT(MetricCounter::POSTINGS_VISITED, candidates.size());
+            control.OnPostingsVisited(candidates.size());
+            for (const int document_id : candidates)
+            {
+                if (block_left == 0)
+                {
+                    block_left = POSTING_BLOCK_SIZE;
+                    control.OnPostingsScored(POSTING_BLOCK_SIZE);
+                    if (control.ShouldStop())
+                    {
+                        break;
+                    }
+                }
+                --block_left;
+                const int slot = documents_.at(document_id).slot;
+                if (!IsAccepted(predicate, document_id, slot))
+                {
+                    control.OnPredicateReject();
+                    continue;
+                }
+                const auto &word_freqs = document2words_freqs.at(document_id);
+                const bool has_minus_word = std::any_of(query.minus_words.begin(), query.minus_words.end(),
+                                                        [&word_freqs](std::string_view word)
+                                                        { return word_freqs.count(word) > 0; });
+                if (has_minus_word || !MatchesPhrases(query, document_id))
+                {
+                    control.OnMinusExclusion();
+                    continue;
+                }
+                double relevance = 0.0;
+                for (const auto &[word, scorer] : plus_words)
+                {
+                    if (const auto it = word_freqs.find(word); it != word_freqs.end())
+                    {
+                        relevance += scorer.Score(it->second, length_by_slot_[slot]);
+                    }
+                }
+                matched_documents.push_back({document_id, relevance, rating_by_slot_[slot]});
+            }
+        }
+        control.OnPostingsScored(POSTING_BLOCK_SIZE - block_left);
+    }
+    control.OnDocumentsScored(candidate_count);
+    METRIC_INCREMENT(MetricCounter::DOCUMENTS_SCORED, candidate_count);
+    return matched_documents;
+}
+
+// Алгоритм порогов Фейгина: слова читаются по очереди в порядке убывания вклада, каждый новый
+// документ оценивается целиком по прямому индексу. Порог - сумма текущих вкладов всех слов,
+// это верхняя граница релевантности ещё не встреченных документов.
+template <typename Predicate>
+std::vector<Document> SearchServer::FindTopDocumentsByImpact(const Query &query, Predicate predicate, size_t count) const
+{
+    struct Cursor
+    {
+        const std::vector<ImpactPosting> *postings;
+        size_t position;
+        double inverse_document_freq;
+    };
+    std::vector<Cursor> cursors;
+    std::vector<std::pair<std::string_view, double>> plus_words;
+    for (const std::string_view word : query.plus_words)
+    {
+        const auto it = impact_postings_.find(word);
+        const auto freqs_it = word_to_document_freqs_.find(word);
+        if (it == impact_postings_.end() || freqs_it == word_to_document_freqs_.end() || freqs_it->second.GetDocumentCount() == 0)
+        {
+            continue;
+        }
+        const double inverse_document_freq = ComputeTermWeight(query, word);
+        cursors.push_back({&it->second, 0, inverse_document_freq});
+        plus_words.emplace_back(word, inverse_document_freq);
     }
 
+    std::vector<Document> top;
+    QueryArena arena(&memory_->query_arenas);
+    std::pmr::unordered_set<int> seen(arena.GetResource());
+    const auto evaluate = [&](int document_id)
+    {
+        const auto words_it = document2words_freqs.find(document_id);
+        if (words_it == document2words_freqs.end())
+        {
+            return;
+        }
+        const int slot = documents_.at(document_id).slot;
+        if (!IsAccepted(predicate, document_id, slot))
+        {
+            return;
+        }
+        const auto &word_freqs = words_it->second;
+        for (const std::string_view word : query.minus_words)
+        {
+            if (word_freqs.count(word) > 0)
+            {
+                return;
+            }
+        }
+        double relevance = 0.0;
+        for (const auto &[word, inverse_document_freq] : plus_words)
+        {
+            if (const auto it = word_freqs.find(word); it != word_freqs.end())
+            {
+                relevance += it->second * inverse_document_freq;
+            }
+        }
+        top.push_back({document_id, relevance, rating_by_slot_[slot]});
+        std::push_heap(top.begin(), top.end(), IsMoreRelevant);
+        if (top.size() > count)
+        {
+            std::pop_heap(top.begin(), top.end(), IsMoreRelevant);
+            top.pop_back();
+        }
+    };
+
+    while (true)
+    {
+        double threshold = 0.0;
+        bool exhausted = true;
+        for (const Cursor &cursor : cursors)
+        {
+            if (cursor.position < cursor.postings->size())
+            {
+                exhausted = false;
+                threshold += (*cursor.postings)[cursor.position].impact * (1.0 / MAX_IMPACT) * cursor.inverse_document_freq;
+            }
+        }
+        // при равной с точностью до EPS релевантности решает рейтинг, поэтому нужен запас EPS
+        if (exhausted || (top.size() == count && top.front().relevance > threshold + EPS))
+        {
+            break;
+        }
+        for (Cursor &cursor : cursors)
+        {
+            if (cursor.position < cursor.postings->size())
+            {
+                const int document_id = (*cursor.postings)[cursor.position++].document_id;
+                if (seen.insert(document_id).second)
+                {
+                    evaluate(document_id);
+                }
+            }
+        }
+    }
 
-}
\ No newline at end of file
+    std::sort(top.begin(), top.end(), IsMoreRelevant);
+    return top;
+}
@@ -0,0 +1,347 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+std::vector<int> ParseCpuList(const std::string &text)
+{
+    std::vector<int> cpus;
+    std::istringstream input(text);
+    std::string range;
+    while (std::getline(input, range, ','))
+    {
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+}
+
+std::vector<std::vector<int>> ReadNumaNodeCpus()
+{
+    std::vector<std::vector<int>> nodes;
+    for (int node = 0;; ++node)
+    {
+        std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string text;
+        if (!input || !std::getline(input, text))
+        {
+            break;
+        }
+        nodes.push_back(ParseCpuList(text));
+    }
+    return nodes;
+}
+
+ShardedSearchServer::ShardWorker::ShardWorker(std::vector<int> cpus)
+    : thread_([this, cpus = std::move(cpus)]() { Run(cpus); })
+{
+}
+
+ShardedSearchServer::ShardWorker::~ShardWorker()
+{
+    {
+        std::lock_guard guard(mutex_);
+        stopping_ = true;
+    }
+    has_task_.notify_one();
+    thread_.join();
+}
+
+std::future<void> ShardedSearchServer::ShardWorker::Submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> result = packaged.get_future();
+    {
+        std::lock_guard guard(mutex_);
+        tasks_.push_back(std::move(packaged));
+    }
+    has_task_.notify_one();
+    return result;
+}
+
+void ShardedSearchServer::ShardWorker::Run(const std::vector<int> &cpus)
+{
+#ifdef __linux__
+    // закрепление - оптимизация: если не вышло, поток просто работает где придётся
+    if (!cpus.empty())
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (const int cpu : cpus)
+        {
+            CPU_SET(cpu, &cpu_set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+#endif
+    while (true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            has_task_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+            {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+ShardedSearchServer::ShardedSearchServer(const std::string &stop_words_text, const ShardingOptions &options)
+{
+    if (options.shard_count == 0)
+    {
+        throw std::invalid_argument("shard_count must be positive");
+    }
+    const std::vector<std::vector<int>> nodes = options.pin_to_numa_nodes ? ReadNumaNodeCpus()
+                                                                          : std::vector<std::vector<int>>{};
+    for (size_t i = 0; i < options.shard_count; ++i)
+    {
+        shards_.push_back(std::make_unique<SearchServer>(stop_words_text));
+        shards_.back()->SetCorpusStatistics(&statistics_);
+        workers_.push_back(std::make_unique<ShardWorker>(nodes.empty() ? std::vector<int>{} : nodes[i % nodes.size()]));
+    }
+}
+
+// потоки останавливаются раньше, чем разрушаются шарды, с которыми они работают
+ShardedSearchServer::~ShardedSearchServer()
+{
+    workers_.clear();
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const
+{
+    // перемешивание Фибоначчи: идущие подряд и кратные числу шардов id распределяются равномерно
+    const uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(document_id)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>((hash >> 32) % shards_.size());
+}
+
+void ShardedSearchServer::AddDocument(int document_id, const std::string &document, DocumentStatus status,
+                                      const std::vector<int> &ratings)
+{
+    const size_t index = GetShardIndex(document_id);
+    SearchServer &shard = *shards_[index];
+    workers_[index]->Submit([&]() { shard.AddDocument(document_id, document, status, ratings); }).get();
+
+    std::vector<std::string_view> words;
+    for (const auto &[word, _] : shard.GetWordFrequencies(document_id))
+    {
+        words.push_back(word);
+    }
+    statistics_.AddDocument(words, shard.GetDocumentLength(document_id));
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id)
+{
+    const size_t index = GetShardIndex(document_id);
+    SearchServer &shard = *shards_[index];
+    const auto &word_freqs = shard.GetWordFrequencies(document_id);
+    if (word_freqs.empty())
+    {
+        return;
+    }
+    std::vector<std::string_view> words;
+    for (const auto &[word, _] : word_freqs)
+    {
+        words.push_back(word);
+    }
+    statistics_.RemoveDocument(words, shard.GetDocumentLength(document_id));
+    workers_[index]->Submit([&]() { shard.RemoveDocument(document_id); }).get();
+}
+
+void ShardedSearchServer::RemoveDocuments(const std::vector<int> &document_ids)
+{
+    // повтор id в пачке не должен дважды вычесть документ из общей статистики
+    std::vector<int> unique_ids = document_ids;
+    std::sort(unique_ids.begin(), unique_ids.end());
+    unique_ids.erase(std::unique(unique_ids.begin(), unique_ids.end()), unique_ids.end());
+
+    std::vector<std::vector<int>> ids_by_shard(shards_.size());
+    for (const int document_id : unique_ids)
+    {
+        const size_t index = GetShardIndex(document_id);
+        const auto &word_freqs = shards_[index]->GetWordFrequencies(document_id);
+        if (word_freqs.empty())
+        {
+            continue;
+        }
+        std::vector<std::string_view> words;
+        for (const auto &[word, _] : word_freqs)
+        {
+            words.push_back(word);
+        }
+        statistics_.RemoveDocument(words, shards_[index]->GetDocumentLength(document_id));
+        ids_by_shard[index].push_back(document_id);
+    }
+
+    std::vector<std::future<void>> results;
+    for (size_t index = 0; index < shards_.size(); ++index)
+    {
+        if (!ids_by_shard[index].empty())
+        {
+            SearchServer &shard = *shards_[index];
+            const std::vector<int> &ids = ids_by_shard[index];
+            results.push_back(workers_[index]->Submit([&shard, &ids]() { shard.RemoveDocuments(ids); }));
+        }
+    }
+    for (auto &result : results)
+    {
+        result.get();
+    }
+}
+
+int ShardedSearchServer::GetDocumentCount() const
+{
+    return statistics_.document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const
+{
+    return shards_.size();
+}
+
+const SearchServer &ShardedSearchServer::GetShard(size_t index) const
+{
+    return *shards_.at(index);
+}
+
+void ShardedSearchServer::SetRankingOptions(const RankingOptions &options)
+{
+    for (const auto &shard : shards_)
+    {
+        shard->SetRankingOptions(options);
+    }
+}
+
+void ShardedSearchServer::SetTermExpansionOptions(const TermExpansionOptions &options)
+{
+    for (const auto &shard : shards_)
+    {
+        shard->SetTermExpansionOptions(options);
+    }
+}
+
+void ShardedSearchServer::SetStopWords(const std::string &stop_words_text)
+{
+    for (const auto &shard : shards_)
+    {
+        shard->SetStopWords(stop_words_text);
+    }
+}
+
+void ShardedSearchServer::SetAnalyzerOptions(const AnalyzerOptions &options)
+{
+    for (const auto &shard : shards_)
+    {
+        shard->SetAnalyzerOptions(options);
+    }
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view raw_query,
+                                                            DocumentStatus status_seek) const
+{
+    return FindTopDocuments(raw_query, StatusFilter{status_seek});
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus>
+ShardedSearchServer::MatchDocument(const std::string_view raw_query, int document_id) const
+{
+    return shards_[GetShardIndex(document_id)]->MatchDocument(raw_query, document_id);
+}
+
+void ShardedSearchServer::WaitAll(std::vector<std::future<void>> &futures)
+{
+    // задачи ссылаются на стек вызывающего, поэтому ждём все, даже если какая-то упала
+    std::exception_ptr error;
+    for (auto &future : futures)
+    {
+        try
+        {
+            future.get();
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+std::vector<std::vector<Document>> ShardedSearchServer::Scatter(
+        const std::function<std::vector<Document>(const SearchServer &)> &search) const
+{
+    std::vector<std::vector<Document>> results(shards_.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i)
+    {
+        futures.push_back(workers_[i]->Submit([&, i]() { results[i] = search(*shards_[i]); }));
+    }
+    WaitAll(futures);
+    return results;
+}
+
+// Слияние уже упорядоченных топов шардов: в куче по одному текущему документу от каждого шарда
+std::vector<Document> ShardedSearchServer::MergeTopDocuments(std::vector<std::vector<Document>> shard_results)
+{
+    using Head = std::pair<size_t, size_t>;
+    const auto is_less_relevant = [&shard_results](const Head &lhs, const Head &rhs)
+    {
+        return SearchServer::IsMoreRelevant(shard_results[rhs.first][rhs.second],
+                                            shard_results[lhs.first][lhs.second]);
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(is_less_relevant)> heads(is_less_relevant);
+    for (size_t shard = 0; shard < shard_results.size(); ++shard)
+    {
+        if (!shard_results[shard].empty())
+        {
+            heads.emplace(shard, 0);
+        }
+    }
+
+    std::vector<Document> result;
+    while (!heads.empty() && result.size() < static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT))
+    {
+        const auto [shard, position] = heads.top();
+        heads.pop();
+        result.push_back(shard_results[shard][position]);
+        if (position + 1 < shard_results[shard].size())
+        {
+            heads.emplace(shard, position + 1);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "corpus_statistics.h"
+#include "document.h"
+#include "search_server.h"
+
+struct ShardingOptions
+{
+    size_t shard_count = 1;
+    // поток шарда i закрепляется за процессорами узла NUMA i % число узлов
+    bool pin_to_numa_nodes = false;
+};
+
+// Документы распределяются по шардам по хешу id. Каждый шард обслуживает свой поток, поэтому
+// память шарда выделяется на его узле NUMA, а запрос выполняется всеми шардами параллельно.
+// idf, средняя длина документа и раскрытия префиксов и опечаток берутся из общей статистики,
+// так что результаты совпадают с одним SearchServer над всеми документами. Как и SearchServer, не допускает изменений
+// одновременно с запросами
+class ShardedSearchServer
+{
+public:
+    ShardedSearchServer(const std::string &stop_words_text, const ShardingOptions &options);
+    ~ShardedSearchServer();
+
+    void AddDocument(int document_id, const std::string &document, DocumentStatus status, const std::vector<int> &ratings);
+    void RemoveDocument(int document_id);
+    // шарды удаляют свои документы одновременно
+    void RemoveDocuments(const std::vector<int> &document_ids);
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+    size_t GetShardIndex(int document_id) const;
+    const SearchServer &GetShard(size_t index) const;
+    void SetRankingOptions(const RankingOptions &options);
+    void SetTermExpansionOptions(const TermExpansionOptions &options);
+    void SetStopWords(const std::string &stop_words_text);
+    void SetAnalyzerOptions(const AnalyzerOptions &options);
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query,
+                                           DocumentStatus status_seek = DocumentStatus::ACTUAL) const;
+
+    template <typename Predicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, Predicate predicate) const
+    {
+        return MergeTopDocuments(Scatter([&](const SearchServer &shard)
+                                         { return shard.FindTopDocuments(raw_query, predicate); }));
+    }
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query,
+                                                                            int document_id) const;
+
+private:
+    // Поток, выполняющий все операции одного шарда по очереди
+    class ShardWorker
+    {
+    public:
+        explicit ShardWorker(std::vector<int> cpus);
+        ~ShardWorker();
+
+        std::future<void> Submit(std::function<void()> task);
+
+    private:
+        void Run(const std::vector<int> &cpus);
+
+        std::mutex mutex_;
+        std::condition_variable has_task_;
+        std::deque<std::packaged_task<void()>> tasks_;
+        bool stopping_ = false;
+        std::thread thread_;
+    };
+
+    std::vector<std::vector<Document>> Scatter(
+            const std::function<std::vector<Document>(const SearchServer &)> &search) const;
+    static std::vector<Document> MergeTopDocuments(std::vector<std::vector<Document>> shard_results);
+    static void WaitAll(std::vector<std::future<void>> &futures);
+
+    CorpusStatistics statistics_;
+    std::vector<std::unique_ptr<SearchServer>> shards_;
+    // mutable: запрос только ставит задачи в очередь
+    mutable std::vector<std::unique_ptr<ShardWorker>> workers_;
+};
+
+// процессоры каждого узла NUMA из /sys/devices/system/node; пусто, если узлы не видны
+std::vector<std::vector<int>> ReadNumaNodeCpus();
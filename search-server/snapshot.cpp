@@ -0,0 +1,306 @@
+#include "snapshot.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+int ParseInt(std::string_view text)
+{
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size())
+    {
+        throw std::invalid_argument("invalid number");
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(int value)
+{
+    if (value < 0 || value >= DOCUMENT_STATUS_COUNT)
+    {
+        throw std::invalid_argument("unknown document status");
+    }
+    return static_cast<DocumentStatus>(value);
+}
+
+std::vector<int> ParseRatings(std::string_view text)
+{
+    std::vector<int> ratings;
+    while (!text.empty())
+    {
+        const size_t comma = std::min(text.find(','), text.size());
+        ratings.push_back(ParseInt(text.substr(0, comma)));
+        text.remove_prefix(std::min(text.size(), comma + 1));
+    }
+    return ratings;
+}
+
+// Разбор одного плоского JSON-объекта: числа, массив чисел и строки, без вложенных объектов
+class JsonCursor
+{
+public:
+    explicit JsonCursor(std::string_view text) : text_(text)
+    {
+    }
+
+    void SkipSpaces()
+    {
+        while (!text_.empty() && (text_[0] == ' ' || text_[0] == '\t' || text_[0] == '\r'))
+        {
+            text_.remove_prefix(1);
+        }
+    }
+
+    bool TryConsume(char c)
+    {
+        SkipSpaces();
+        if (!text_.empty() && text_[0] == c)
+        {
+            text_.remove_prefix(1);
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c)
+    {
+        if (!TryConsume(c))
+        {
+            throw std::invalid_argument(std::string("expected '") + c + "'");
+        }
+    }
+
+    int ReadInt()
+    {
+        SkipSpaces();
+        size_t size = 0;
+        while (size < text_.size() && (text_[size] == '-' || (text_[size] >= '0' && text_[size] <= '9')))
+        {
+            ++size;
+        }
+        const int value = ParseInt(text_.substr(0, size));
+        text_.remove_prefix(size);
+        return value;
+    }
+
+    std::string ReadString()
+    {
+        Expect('"');
+        std::string result;
+        while (true)
+        {
+            const size_t special = text_.find_first_of("\\\"");
+            if (special == text_.npos)
+            {
+                throw std::invalid_argument("unterminated string");
+            }
+            result.append(text_.substr(0, special));
+            const char c = text_[special];
+            text_.remove_prefix(special + 1);
+            if (c == '"')
+            {
+                return result;
+            }
+            if (text_.empty())
+            {
+                throw std::invalid_argument("unterminated escape");
+            }
+            const char escaped = text_[0];
+            text_.remove_prefix(1);
+            switch (escaped)
+            {
+            case 'n':
+            case 't':
+            case 'r':
+            case 'b':
+            case 'f':
+                // управляющие символы в тексте документа запрещены, как и в AddDocument
+                result.push_back(' ');
+                break;
+            case 'u':
+                AppendCodePoint(result);
+                break;
+            default:
+                result.push_back(escaped);
+            }
+        }
+    }
+
+    bool AtEnd()
+    {
+        SkipSpaces();
+        return text_.empty();
+    }
+
+private:
+    uint32_t ReadHexQuad()
+    {
+        if (text_.size() < 4)
+        {
+            throw std::invalid_argument("invalid \\u escape");
+        }
+        uint32_t value = 0;
+        const auto [end, error] = std::from_chars(text_.data(), text_.data() + 4, value, 16);
+        if (error != std::errc() || end != text_.data() + 4)
+        {
+            throw std::invalid_argument("invalid \\u escape");
+        }
+        text_.remove_prefix(4);
+        return value;
+    }
+
+    // символы вне BMP приходят суррогатной парой \uD83D\uDE00 и собираются в один код
+    void AppendCodePoint(std::string &result)
+    {
+        uint32_t code_point = ReadHexQuad();
+        if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+        {
+            throw std::invalid_argument("unpaired surrogate in \\u escape");
+        }
+        if (code_point >= 0xD800 && code_point <= 0xDBFF)
+        {
+            if (text_.substr(0, 2) != "\\u")
+            {
+                throw std::invalid_argument("unpaired surrogate in \\u escape");
+            }
+            text_.remove_prefix(2);
+            const uint32_t low = ReadHexQuad();
+            if (low < 0xDC00 || low > 0xDFFF)
+            {
+                throw std::invalid_argument("unpaired surrogate in \\u escape");
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+        }
+
+        if (code_point < 0x20)
+        {
+            result.push_back(' ');
+        }
+        else if (code_point < 0x80)
+        {
+            result.push_back(static_cast<char>(code_point));
+        }
+        else if (code_point < 0x800)
+        {
+            result.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else if (code_point < 0x10000)
+        {
+            result.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else
+        {
+            result.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+
+    std::string_view text_;
+};
+}
+
+SnapshotRecord ParseSnapshotLine(std::string_view line)
+{
+    std::string_view fields[3];
+    for (std::string_view &field : fields)
+    {
+        const size_t tab = line.find('\t');
+        if (tab == line.npos)
+        {
+            throw std::invalid_argument("expected 4 tab-separated fields");
+        }
+        field = line.substr(0, tab);
+        line.remove_prefix(tab + 1);
+    }
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+    return {ParseInt(fields[0]), ParseStatus(ParseInt(fields[1])), ParseRatings(fields[2]), std::string(line)};
+}
+
+SnapshotRecord ParseJsonSnapshotLine(std::string_view line)
+{
+    SnapshotRecord record;
+    bool has_id = false;
+    bool has_text = false;
+    JsonCursor cursor(line);
+    cursor.Expect('{');
+    if (!cursor.TryConsume('}'))
+    {
+        do
+        {
+            const std::string key = cursor.ReadString();
+            cursor.Expect(':');
+            if (key == "id")
+            {
+                record.id = cursor.ReadInt();
+                has_id = true;
+            }
+            else if (key == "status")
+            {
+                record.status = ParseStatus(cursor.ReadInt());
+            }
+            else if (key == "ratings")
+            {
+                cursor.Expect('[');
+                if (!cursor.TryConsume(']'))
+                {
+                    do
+                    {
+                        record.ratings.push_back(cursor.ReadInt());
+                    } while (cursor.TryConsume(','));
+                    cursor.Expect(']');
+                }
+            }
+            else if (key == "text")
+            {
+                record.text = cursor.ReadString();
+                has_text = true;
+            }
+            else
+            {
+                throw std::invalid_argument("unknown field " + key);
+            }
+        } while (cursor.TryConsume(','));
+        cursor.Expect('}');
+    }
+    if (!cursor.AtEnd() || !has_id || !has_text)
+    {
+        throw std::invalid_argument("expected an object with id and text");
+    }
+    return record;
+}
+
+int LoadSnapshot(SearchServer &server, std::istream &input)
+{
+    int loaded = 0;
+    int line_number = 0;
+    std::string line;
+    while (std::getline(input, line))
+    {
+        ++line_number;
+        if (line.empty())
+        {
+            continue;
+        }
+        try
+        {
+            SnapshotRecord record = ParseSnapshotLine(line);
+            server.AddDocument(record.id, record.text, record.status, record.ratings);
+            ++loaded;
+        }
+        catch (const std::exception &e)
+        {
+            throw std::invalid_argument("snapshot line " + std::to_string(line_number) + ": " + e.what());
+        }
+    }
+    return loaded;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Документ снимка. Форматы строки:
+//   TSV:   id<TAB>статус<TAB>рейтинги через запятую<TAB>текст
+//   JSONL: {"id": 1, "status": 0, "ratings": [1, 2], "text": "..."}
+// статус - число DocumentStatus
+struct SnapshotRecord
+{
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    std::string text;
+};
+
+// ошибка разбора - std::invalid_argument
+SnapshotRecord ParseSnapshotLine(std::string_view line);
+SnapshotRecord ParseJsonSnapshotLine(std::string_view line);
+
+// Снимок в TSV. Возвращает число загруженных документов; номер строки
+// с ошибкой попадает в текст std::invalid_argument
+int LoadSnapshot(SearchServer &server, std::istream &input);
@@ -0,0 +1,103 @@
+#include "stop_words.h"
+
+#include <algorithm>
+
+namespace
+{
+// слов на корзину в среднем; больше - меньше таблица смещений, но дольше подбор
+const size_t WORDS_PER_BUCKET = 4;
+// перебор смещений одной корзины, после которого таблица ячеек удваивается
+const uint32_t MAX_DISPLACEMENT = 1 << 16;
+}
+
+StopWordSet::StopWordSet(std::vector<std::string> words) : words_(std::move(words))
+{
+    words_.erase(std::remove_if(words_.begin(), words_.end(), [](const std::string &word) { return word.empty(); }),
+                 words_.end());
+    std::sort(words_.begin(), words_.end());
+    words_.erase(std::unique(words_.begin(), words_.end()), words_.end());
+    if (words_.empty())
+    {
+        return;
+    }
+
+    // заполнение не больше половины: смещения находятся за несколько попыток
+    size_t slot_count = 1;
+    while (slot_count < words_.size() * 2)
+    {
+        slot_count *= 2;
+    }
+    while (!TryBuild(slot_count))
+    {
+        slot_count *= 2;
+    }
+
+    memory_usage_ = words_.capacity() * sizeof(std::string) + displacements_.capacity() * sizeof(uint32_t)
+                    + slots_.capacity() * sizeof(int32_t);
+    for (const std::string &word : words_)
+    {
+        memory_usage_ += word.size();
+    }
+}
+
+bool StopWordSet::TryBuild(size_t slot_count)
+{
+    const size_t bucket_count = (words_.size() + WORDS_PER_BUCKET - 1) / WORDS_PER_BUCKET;
+    std::vector<std::vector<int32_t>> buckets(bucket_count);
+    std::vector<uint64_t> hashes(words_.size());
+    for (size_t i = 0; i < words_.size(); ++i)
+    {
+        hashes[i] = Hash(words_[i]);
+        buckets[Mix(hashes[i], 0) % bucket_count].push_back(static_cast<int32_t>(i));
+    }
+
+    // большие корзины раскладываются первыми, пока свободных ячеек много
+    std::vector<size_t> order(bucket_count);
+    for (size_t i = 0; i < bucket_count; ++i)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs)
+              { return buckets[lhs].size() > buckets[rhs].size(); });
+
+    displacements_.assign(bucket_count, 0);
+    slots_.assign(slot_count, -1);
+    slot_mask_ = slot_count - 1;
+    std::vector<uint64_t> candidate;
+    for (const size_t bucket : order)
+    {
+        if (buckets[bucket].empty())
+        {
+            break;
+        }
+        bool placed = false;
+        for (uint32_t displacement = 1; displacement < MAX_DISPLACEMENT && !placed; ++displacement)
+        {
+            candidate.clear();
+            placed = true;
+            for (const int32_t index : buckets[bucket])
+            {
+                const uint64_t slot = Mix(hashes[index], displacement) & slot_mask_;
+                if (slots_[slot] >= 0 || std::find(candidate.begin(), candidate.end(), slot) != candidate.end())
+                {
+                    placed = false;
+                    break;
+                }
+                candidate.push_back(slot);
+            }
+            if (placed)
+            {
+                displacements_[bucket] = displacement;
+                for (size_t i = 0; i < candidate.size(); ++i)
+                {
+                    slots_[candidate[i]] = buckets[bucket][i];
+                }
+            }
+        }
+        if (!placed)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Неизменяемое множество стоп-слов на совершенном хеше (hash and displace): слово попадает
+// в корзину по первому хешу, смещение корзины подобрано при построении так, что второй хеш
+// всех слов разводит их по разным ячейкам. Проверка - два хеша и одно сравнение строк
+class StopWordSet
+{
+public:
+    StopWordSet() = default;
+    // повторы и пустые строки отбрасываются
+    explicit StopWordSet(std::vector<std::string> words);
+
+    bool Contains(std::string_view word) const
+    {
+        if (words_.empty())
+        {
+            return false;
+        }
+        const uint64_t hash = Hash(word);
+        const uint32_t displacement = displacements_[Mix(hash, 0) % displacements_.size()];
+        const int32_t index = slots_[Mix(hash, displacement) & slot_mask_];
+        return index >= 0 && words_[index] == word;
+    }
+
+    size_t GetSize() const
+    {
+        return words_.size();
+    }
+
+    // по возрастанию
+    const std::vector<std::string> &GetWords() const
+    {
+        return words_;
+    }
+
+    // примерный объём в байтах, считается при построении
+    size_t GetMemoryUsage() const
+    {
+        return memory_usage_;
+    }
+
+private:
+    // FNV-1a
+    static uint64_t Hash(std::string_view word)
+    {
+        uint64_t result = 14695981039346656037ull;
+        for (const char c : word)
+        {
+            result = (result ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return result;
+    }
+
+    // финализатор splitmix64, seed выбирает функцию из семейства
+    static uint64_t Mix(uint64_t hash, uint64_t seed)
+    {
+        hash ^= seed * 0x9E3779B97F4A7C15ull;
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+        return hash ^ (hash >> 31);
+    }
+
+    bool TryBuild(size_t slot_count);
+
+    std::vector<std::string> words_;
+    std::vector<uint32_t> displacements_;
+    // индекс слова в words_ или -1
+    std::vector<int32_t> slots_;
+    uint64_t slot_mask_ = 0;
+    size_t memory_usage_ = 0;
+};